@@ -0,0 +1,293 @@
+# ifndef BATCH_H
+# define BATCH_H
+
+// a minimal io_uring, only what is needed to run many statx at once
+class uring {
+	private:
+
+		int fd = -1;
+		unsigned int depth = 0;
+
+		void *submission_ring = MAP_FAILED;
+		void *completion_ring = MAP_FAILED;
+		std::size_t submission_size = 0;
+		std::size_t completion_size = 0;
+
+		struct io_uring_sqe *sqes = static_cast<struct io_uring_sqe*>(MAP_FAILED);
+		std::size_t sqes_size = 0;
+
+		unsigned int *submission_head, *submission_tail, *submission_mask, *submission_array;
+		unsigned int *completion_head, *completion_tail, *completion_mask;
+		struct io_uring_cqe *cqes;
+
+		void release() {
+			if(sqes != MAP_FAILED) {
+				munmap(sqes, sqes_size);
+			}
+			if(completion_ring != MAP_FAILED && completion_ring != submission_ring) {
+				munmap(completion_ring, completion_size);
+			}
+			if(submission_ring != MAP_FAILED) {
+				munmap(submission_ring, submission_size);
+			}
+			if(fd != -1) {
+				close(fd);
+			}
+
+			fd = -1;
+			sqes = static_cast<struct io_uring_sqe*>(MAP_FAILED);
+			submission_ring = completion_ring = MAP_FAILED;
+		}
+
+		// after a failed enter. what the kernel did not take yet is taken
+		// back and what it took is waited for, so nothing writes into the
+		// results afterwards and the next batch starts on an empty ring
+		void abandon(std::size_t in_flight) {
+			unsigned int head = __atomic_load_n(submission_head, __ATOMIC_ACQUIRE);
+			in_flight -= *submission_tail - head;
+			__atomic_store_n(submission_tail, head, __ATOMIC_RELEASE);
+
+			while(true) {
+				unsigned int completion = *completion_head;
+				while(in_flight > 0 && completion != __atomic_load_n(completion_tail, __ATOMIC_ACQUIRE)) {
+					completion++;
+					in_flight--;
+				}
+				__atomic_store_n(completion_head, completion, __ATOMIC_RELEASE);
+
+				if(in_flight == 0) {
+					return;
+				}
+
+				// statx runs on kernel workers, its completions come in even
+				// if enter keeps failing
+				stats::syscalls++;
+				if(syscall(__NR_io_uring_enter, fd, 0, in_flight, IORING_ENTER_GETEVENTS, nullptr, 0) < 0) {
+					std::this_thread::sleep_for(std::chrono::microseconds(100));
+				}
+			}
+		}
+
+	public:
+
+		~uring() {
+			release();
+		}
+
+		// false if the kernel has no io_uring or does not allow it
+		bool setup(unsigned int depth_) {
+			struct io_uring_params params;
+			memset(&params, 0, sizeof(params));
+
+			stats::syscalls++;
+			fd = syscall(__NR_io_uring_setup, depth_, &params);
+			if(fd < 0) {
+				fd = -1;
+				return false;
+			}
+			depth = params.sq_entries;
+
+			submission_size = params.sq_off.array + params.sq_entries * sizeof(unsigned int);
+			completion_size = params.cq_off.cqes + params.cq_entries * sizeof(struct io_uring_cqe);
+
+			// newer kernels map both rings at once
+			bool single = params.features & IORING_FEAT_SINGLE_MMAP;
+			if(single) {
+				submission_size = completion_size = std::max(submission_size, completion_size);
+			}
+
+			submission_ring = mmap(nullptr, submission_size, PROT_READ | PROT_WRITE,
+					MAP_SHARED | MAP_POPULATE, fd, IORING_OFF_SQ_RING);
+			if(submission_ring == MAP_FAILED) {
+				release();
+				return false;
+			}
+
+			completion_ring = single ? submission_ring : mmap(nullptr, completion_size, PROT_READ | PROT_WRITE,
+					MAP_SHARED | MAP_POPULATE, fd, IORING_OFF_CQ_RING);
+			if(completion_ring == MAP_FAILED) {
+				release();
+				return false;
+			}
+
+			sqes_size = params.sq_entries * sizeof(struct io_uring_sqe);
+			sqes = static_cast<struct io_uring_sqe*>(mmap(nullptr, sqes_size, PROT_READ | PROT_WRITE,
+					MAP_SHARED | MAP_POPULATE, fd, IORING_OFF_SQES));
+			if(sqes == MAP_FAILED) {
+				release();
+				return false;
+			}
+
+			char *submission = static_cast<char*>(submission_ring);
+			submission_head = reinterpret_cast<unsigned int*>(submission + params.sq_off.head);
+			submission_tail = reinterpret_cast<unsigned int*>(submission + params.sq_off.tail);
+			submission_mask = reinterpret_cast<unsigned int*>(submission + params.sq_off.ring_mask);
+			submission_array = reinterpret_cast<unsigned int*>(submission + params.sq_off.array);
+
+			char *completion = static_cast<char*>(completion_ring);
+			completion_head = reinterpret_cast<unsigned int*>(completion + params.cq_off.head);
+			completion_tail = reinterpret_cast<unsigned int*>(completion + params.cq_off.tail);
+			completion_mask = reinterpret_cast<unsigned int*>(completion + params.cq_off.ring_mask);
+			cqes = reinterpret_cast<struct io_uring_cqe*>(completion + params.cq_off.cqes);
+
+			return true;
+		}
+
+		// statx of every name, results are filled in as completions arrive.
+		// at most depth requests are in flight at a time. false if the ring
+		// failed, nothing is in flight then
+		bool statx_all(int directory_fd, const char *const *names, std::size_t count, int flags, unsigned int mask,
+				struct statx *results, int *errors) {
+
+			std::size_t submitted = 0, completed = 0;
+			unsigned int pending = 0;
+
+			while(completed < count) {
+				unsigned int tail = *submission_tail;
+				unsigned int head = __atomic_load_n(submission_head, __ATOMIC_ACQUIRE);
+
+				while(submitted < count && submitted - completed < depth && tail - head < depth) {
+					unsigned int slot = tail & *submission_mask;
+					struct io_uring_sqe &sqe = sqes[slot];
+					memset(&sqe, 0, sizeof(sqe));
+
+					sqe.opcode = IORING_OP_STATX;
+					sqe.fd = directory_fd;
+					sqe.addr = reinterpret_cast<unsigned long>(names[submitted]);
+					sqe.len = mask;
+					sqe.off = reinterpret_cast<unsigned long>(&results[submitted]);
+					sqe.statx_flags = flags;
+					sqe.user_data = submitted;
+
+					submission_array[slot] = slot;
+					tail++;
+					submitted++;
+					pending++;
+				}
+				__atomic_store_n(submission_tail, tail, __ATOMIC_RELEASE);
+
+				// waits for a quarter of the ring, so it is refilled while
+				// the rest is still busy and each enter reaps many
+				unsigned int wait = std::max(1UL, std::min<unsigned long>(submitted - completed, depth / 4));
+
+				stats::syscalls++;
+				int entered = syscall(__NR_io_uring_enter, fd, pending, wait, IORING_ENTER_GETEVENTS, nullptr, 0);
+				if(entered < 0) {
+					if(errno == EINTR || errno == EAGAIN || errno == EBUSY) {
+						continue;
+					}
+					abandon(submitted - completed);
+					return false;
+				}
+				pending -= entered;
+
+				unsigned int completion = *completion_head;
+				while(completion != __atomic_load_n(completion_tail, __ATOMIC_ACQUIRE)) {
+					const struct io_uring_cqe &cqe = cqes[completion & *completion_mask];
+					if(cqe.user_data < count) {
+						errors[cqe.user_data] = cqe.res < 0 ? -cqe.res : 0;
+					}
+					completion++;
+					completed++;
+				}
+				__atomic_store_n(completion_head, completion, __ATOMIC_RELEASE);
+			}
+
+			return true;
+		}
+};
+
+// metadata of many names in one directory at once, so a cold cache or a
+// network mount works on all of them together instead of one after the
+// other. goes through io_uring when the kernel allows it and through a
+// few threads otherwise
+class stat_batch {
+	private:
+
+		static void run_serial(int directory_fd, const char *const *names, std::size_t count, int flags, unsigned int mask,
+				struct statx *results, int *errors) {
+
+			for(std::size_t i = 0; i < count; i++) {
+				stats::syscalls++;
+				errors[i] = statx(directory_fd, names[i], flags, mask, &results[i]) == 0 ? 0 : errno;
+			}
+		}
+
+		static void run_threads(int directory_fd, const char *const *names, std::size_t count, int flags, unsigned int mask,
+				struct statx *results, int *errors) {
+
+			std::atomic<std::size_t> next(0);
+			auto work = [&]() {
+				std::size_t i;
+				while((i = next++) < count) {
+					errors[i] = statx(directory_fd, names[i], flags, mask, &results[i]) == 0 ? 0 : errno;
+				}
+			};
+
+			int thread_count = std::min(static_cast<std::size_t>(stat_threads), count / 16 + 1);
+
+			std::vector<std::thread> threads;
+			for(int i = 1; i < thread_count; i++) {
+				threads.emplace_back(work);
+			}
+			work();
+			for(auto &thread : threads) {
+				thread.join();
+			}
+
+			stats::syscalls += count;
+		}
+
+	public:
+
+		enum backend_type { AUTOMATIC, SERIAL, URING, THREADS };
+
+		// the backend every batch goes through, benchmarks change it
+		static backend_type &backend() {
+			static backend_type type = AUTOMATIC;
+			return type;
+		}
+
+		// statx of every name relative to directory_fd, errors[i] is 0 or
+		// the errno of names[i]
+		static void run(int directory_fd, const std::vector<const char*> &names, int flags, unsigned int mask,
+				std::vector<struct statx> &results, std::vector<int> &errors) {
+
+			results.resize(names.size());
+			errors.assign(names.size(), 0);
+
+			// the ring is made once per thread and kept, a kernel without it is only asked once
+			static thread_local uring ring;
+			static thread_local bool has_ring = ring.setup(stat_ring_depth);
+
+			std::size_t first = 0;
+
+			backend_type type = backend();
+			if(type == AUTOMATIC) {
+				// a few names are asked for directly first. answered from the
+				// cache that is faster than handing them to other threads
+				first = std::min(names.size(), static_cast<std::size_t>(stat_probe_size));
+
+				unsigned long start = stats::now();
+				run_serial(directory_fd, names.data(), first, flags, mask, results.data(), errors.data());
+				bool cached = stats::now() - start <= first * stat_cached_time;
+
+				type = cached ? SERIAL : has_ring ? URING : THREADS;
+			}
+
+			const char *const *rest = names.data() + first;
+			std::size_t count = names.size() - first;
+
+			if(type == URING && has_ring
+			&& ring.statx_all(directory_fd, rest, count, flags, mask, &results[first], &errors[first])) {
+
+				return;
+			} else if(type == SERIAL) {
+				run_serial(directory_fd, rest, count, flags, mask, &results[first], &errors[first]);
+			} else {
+				run_threads(directory_fd, rest, count, flags, mask, &results[first], &errors[first]);
+			}
+		}
+};
+
+# endif
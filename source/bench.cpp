@@ -0,0 +1,388 @@
+void bench::print_result(std::string name, unsigned long total, int iterations, std::string extra) {
+	std::cout << std::left << std::setw(24) << name << std::right << std::fixed << std::setprecision(3)
+		<< std::setw(12) << total / 1000.0 / iterations << " ms/iter"
+		<< "  " << extra << std::endl;
+}
+
+// renders frames offscreen while scrolling through a directory
+int bench::render(std::vector<std::string> args) {
+	std::string directory = args.empty() ? "/usr/bin" : args[0];
+	static const std::vector<std::array<int, 2>> sizes = {
+		{ 24, 80 }, { 40, 120 }, { 60, 200 }, { 100, 300 }, { 200, 500 },
+	};
+
+	int frames = 200;
+
+	for(const auto &size : sizes) {
+		user_interface ui;
+		ui.init_offscreen(size[0], size[1]);
+		boost::filesystem::current_path(directory);
+		ui.set_current_path(boost::filesystem::current_path().string());
+		commands::load({"main"}, &ui);
+
+		unsigned long damage = 0;
+		unsigned long start = stats::now();
+
+		for(int i = 0; i < frames; i++) {
+			commands::process_command(i % 2 == 0 ? "down" : "up", &ui);
+			ui.render();
+
+			damage += static_cast<memory_surface*>(ui.get_screen())->get_damage()
+				+ static_cast<memory_surface*>(ui.get_main_window())->get_damage()
+				+ static_cast<memory_surface*>(ui.get_preview_window())->get_damage();
+		}
+
+		print_result(std::to_string(size[1]) + "x" + std::to_string(size[0]),
+				stats::now() - start, frames, std::to_string(damage / frames) + " cells/frame");
+	}
+
+	return 0;
+}
+
+// loads one directory into the main pane and reports its memory cost
+int bench::load(std::vector<std::string> args) {
+	std::string directory = args.empty() ? "/usr/bin" : args[0];
+
+	user_interface ui;
+	ui.init_offscreen(40, 120);
+	boost::filesystem::current_path(directory);
+	ui.set_current_path(boost::filesystem::current_path().string());
+
+	unsigned long allocations = stats::allocations;
+	unsigned long allocated_bytes = stats::allocated_bytes;
+	unsigned long start = stats::now();
+
+	commands::load({"main"}, &ui);
+
+	unsigned long total = stats::now() - start;
+
+	struct rusage usage;
+	getrusage(RUSAGE_SELF, &usage);
+
+	print_result("load " + std::to_string(ui.get_main_elements().size()) + " entries", total, 1,
+			std::to_string(stats::allocations - allocations) + " allocations, "
+			+ commands::format_file_size(stats::allocated_bytes - allocated_bytes, size_precision) + " allocated, "
+			+ commands::format_file_size(usage.ru_maxrss * 1024.0, size_precision) + " peak rss");
+
+	return 0;
+}
+
+// times the selection commands over a whole directory
+int bench::select(std::vector<std::string> args) {
+	std::string directory = args.empty() ? "/usr/bin" : args[0];
+
+	user_interface ui;
+	ui.init_offscreen(40, 120);
+	boost::filesystem::current_path(directory);
+	ui.set_current_path(boost::filesystem::current_path().string());
+	commands::load({"main"}, &ui);
+
+	std::string last = std::to_string(ui.get_main_elements().size());
+	std::vector<std::string> selection_commands = {
+		"selectall", "invert", "selectrange 1 " + last, "unselect",
+		"selectglob *1*", "unselect", "selectregex [0-9]+5\\.", "unselect",
+	};
+
+	for(const auto &command : selection_commands) {
+		std::vector<std::string> args = ui.split_into_args(command);
+		std::vector<std::string> argsp(args.begin() + 1, args.end());
+
+		unsigned long start = stats::now();
+		if(args[0] == "selectall") {
+			commands::select_all(&ui);
+		} else if(args[0] == "invert") {
+			commands::invert(&ui);
+		} else if(args[0] == "unselect") {
+			commands::unselect(&ui);
+		} else if(args[0] == "selectrange") {
+			commands::select_range(argsp, &ui);
+		} else {
+			commands::select_pattern(argsp, args[0] == "selectregex", &ui);
+		}
+
+		print_result(command, stats::now() - start, 1,
+				std::to_string(ui.get_selection().size()) + " selected");
+	}
+
+	// marks are carried over to a fresh listing by inode
+	commands::process_command("selectglob *7*", &ui);
+	ui.invalidate();
+
+	unsigned long start = stats::now();
+	commands::load({"main"}, &ui);
+	print_result("reload", stats::now() - start, 1,
+			std::to_string(ui.get_selection().size()) + " selected");
+
+	return 0;
+}
+
+// time to a full listing from a cold page cache, once per stat backend
+int bench::metadata(std::vector<std::string> args) {
+	std::string directory = args.empty() ? "/usr/bin" : args[0];
+
+	static const std::vector<std::pair<std::string, stat_batch::backend_type>> backends = {
+		{ "serial", stat_batch::SERIAL },
+		{ "io_uring", stat_batch::URING },
+		{ "threads", stat_batch::THREADS },
+	};
+
+	for(const auto &backend : backends) {
+		// needs root, without it every run after the first is warm
+		sync();
+		std::ofstream drop("/proc/sys/vm/drop_caches");
+		bool cold = drop && (drop << "3" << std::endl);
+		drop.close();
+
+		stat_batch::backend() = backend.second;
+
+		listing elements;
+		unsigned long syscalls = stats::syscalls;
+		unsigned long start = stats::now();
+
+		commands::read_directory(directory, std::numeric_limits<int>::max(), elements);
+
+		print_result(backend.first, stats::now() - start, 1,
+				std::to_string(elements.size()) + " entries, "
+				+ std::to_string(stats::syscalls - syscalls) + " syscalls"
+				+ (cold ? "" : ", page cache not dropped"));
+	}
+
+	stat_batch::backend() = stat_batch::AUTOMATIC;
+	return 0;
+}
+
+// raw enumeration of a directory, boost paths against getdents64
+int bench::enumerate(std::vector<std::string> args) {
+	std::string directory = args.empty() ? "/usr/bin" : args[0];
+	int iterations = 5;
+
+	unsigned long count = 0;
+	unsigned long start = stats::now();
+
+	for(int i = 0; i < iterations; i++) {
+		boost::system::error_code error;
+		for(const auto &entry : boost::filesystem::directory_iterator(directory, error)) {
+			const std::string &path = entry.path().string();
+			std::string_view filename(path);
+			filename.remove_prefix(path.find_last_of('/') + 1);
+			count += filename.length() != 0;
+		}
+	}
+
+	unsigned long boost_total = stats::now() - start;
+	print_result("directory_iterator", boost_total, iterations, std::to_string(count / iterations) + " entries");
+
+	count = 0;
+	start = stats::now();
+
+	for(int i = 0; i < iterations; i++) {
+		directory_reader reader(directory);
+
+		std::string_view filename;
+		unsigned char type;
+		ino_t inode;
+		while(reader.next(filename, type, inode)) {
+			count += filename.length() != 0;
+		}
+	}
+
+	unsigned long reader_total = stats::now() - start;
+	std::ostringstream speedup;
+	speedup << std::fixed << std::setprecision(1) << static_cast<double>(boost_total) / std::max(reader_total, 1UL) << "x faster";
+
+	print_result("getdents64", reader_total, iterations,
+			std::to_string(count / iterations) + " entries, " + speedup.str());
+
+	return 0;
+}
+
+// yanking paths into a named register and reading them back to paste
+int bench::clipboard(std::vector<std::string> args) {
+	int count = args.empty() ? 100000 : std::stoi(args[0]);
+	int iterations = 20;
+
+	std::vector<std::string> paths;
+	for(int i = 0; i < count; i++) {
+		paths.push_back("/home/user/projects/odyssey/build/file" + std::to_string(i) + ".o");
+	}
+
+	registers store;
+	unsigned long yanked = 0, pasted = 0;
+	std::size_t total = 0;
+
+	for(int i = 0; i < iterations; i++) {
+		std::vector<std::string> copy = paths;
+
+		unsigned long start = stats::now();
+		store.yank('a', std::move(copy));
+		yanked += stats::now() - start;
+
+		start = stats::now();
+		total += store.get('a').size();
+		pasted += stats::now() - start;
+	}
+
+	print_result("yank", yanked, iterations, std::to_string(count) + " paths");
+	print_result("paste", pasted, iterations, std::to_string(total / iterations) + " paths");
+	return 0;
+}
+
+// parsing the git index of a repository and stat'ing every tracked file
+int bench::git(std::vector<std::string> args) {
+	std::string directory = args.empty() ? "." : args[0];
+	int iterations = 5;
+
+	std::size_t entries = 0, dirty = 0;
+	unsigned long syscalls = stats::syscalls;
+	unsigned long start = stats::now();
+
+	for(int i = 0; i < iterations; i++) {
+		std::shared_ptr<const git_snapshot> snapshot = git_status::scan_now(boost::filesystem::absolute(directory).string());
+		if(snapshot == nullptr) {
+			std::cout << "\"" << directory << "\" is not in a git repository" << std::endl;
+			return 1;
+		}
+		entries = snapshot->index.size();
+		dirty = snapshot->dirty.size();
+	}
+
+	print_result("scan", stats::now() - start, iterations,
+			std::to_string(entries) + " entries, " + std::to_string(dirty) + " dirty directories, "
+			+ std::to_string((stats::syscalls - syscalls) / iterations) + " syscalls");
+	return 0;
+}
+
+// listing, copying and removing against a made up filesystem: a huge
+// directory, one whose stats are slow and a copy that fails halfway
+int bench::filesystem(std::vector<std::string> args) {
+	std::size_t count = args.empty() ? 5000000 : std::stoul(args[0]);
+
+	memory_vfs memory;
+	memory.add_generated("/huge", count, 4096);
+	memory.add_generated("/slow", 10000, 4096);
+	memory.set_latency(VFS_STAT, 0);
+
+	memory.make_directory("/tree");
+	for(int i = 0; i < 100; i++) {
+		std::string directory = "/tree/d" + std::to_string(i);
+		memory.make_directory(directory);
+		for(int j = 0; j < 100; j++) {
+			memory.add_file(directory + "/f" + std::to_string(j), 4096);
+		}
+	}
+
+	vfs::use(&memory);
+
+	listing elements;
+	unsigned long start = stats::now();
+	commands::read_directory("/huge", std::numeric_limits<int>::max(), elements);
+	print_result("list", stats::now() - start, 1, std::to_string(elements.size()) + " entries");
+
+	// 5us a stat, batches wait for all of theirs
+	memory.set_latency(VFS_STAT, 5);
+	listing slow;
+	start = stats::now();
+	commands::read_directory("/slow", std::numeric_limits<int>::max(), slow);
+	print_result("list slow stat", stats::now() - start, 1, std::to_string(slow.size()) + " entries, 5us a stat");
+	memory.set_latency(VFS_STAT, 0);
+
+	std::string failed;
+	start = stats::now();
+	int error = memory.copy_all("/tree", "/copy", failed);
+	print_result("copy", stats::now() - start, 1, error == 0 ? "10100 entries" : strerror(error));
+
+	start = stats::now();
+	error = memory.remove_all("/copy", failed);
+	print_result("remove", stats::now() - start, 1, error == 0 ? "10101 entries" : strerror(error));
+
+	// a directory that stops taking files halfway through
+	memory.inject_error(VFS_WRITE, "/partial", EACCES, 5000);
+	failed.clear();
+	start = stats::now();
+	error = memory.copy_all("/tree", "/partial", failed);
+	print_result("copy until EACCES", stats::now() - start, 1,
+			std::string(error != 0 ? strerror(error) : "no error") + " at " + failed);
+
+	vfs::use(nullptr);
+	return 0;
+}
+
+// looking for duplicates below a directory, the page cache decides most of it
+int bench::dupes(std::vector<std::string> args) {
+	std::string directory = args.empty() ? "/usr" : args[0];
+
+	unsigned long files = 0, errors = 0;
+	unsigned long bytes_read = stats::bytes_read;
+	unsigned long start = stats::now();
+
+	std::vector<duplicate_group> groups = duplicate_finder::find(boost::filesystem::absolute(directory).string(), {""},
+			files, errors);
+
+	unsigned long copies = 0;
+	for(const auto &group : groups) {
+		copies += group.files.size() - 1;
+	}
+
+	print_result("dupes", stats::now() - start, 1,
+			std::to_string(files) + " files, " + std::to_string(groups.size()) + " groups, "
+			+ std::to_string(copies) + " copies, "
+			+ commands::format_file_size(stats::bytes_read - bytes_read, size_precision) + " read, "
+			+ std::to_string(errors) + " errors");
+	return 0;
+}
+
+// comparing two trees, with the time until the first batch of rows
+int bench::compare(std::vector<std::string> args) {
+	if(args.size() != 2) {
+		std::cout << "compare needs two directories" << std::endl;
+		return 1;
+	}
+
+	directory_compare comparison;
+	unsigned long bytes_read = stats::bytes_read;
+	unsigned long start = stats::now();
+	unsigned long first = 0;
+
+	comparison.start(boost::filesystem::absolute(args[0]).string(), boost::filesystem::absolute(args[1]).string());
+	while(comparison.is_running()) {
+		struct pollfd event = { comparison.get_fd(), POLLIN, 0 };
+		poll(&event, 1, -1);
+		if(comparison.collect() && first == 0) {
+			first = stats::now() - start;
+		}
+	}
+
+	print_result("compare", stats::now() - start, 1,
+			comparison.describe() + ", " + commands::format_file_size(stats::bytes_read - bytes_read, size_precision)
+			+ " read, first rows after " + std::to_string(first / 1000) + " ms");
+	return 0;
+}
+
+int bench::run(std::vector<std::string> args) {
+	std::vector<std::string> argsp = std::vector<std::string>(args.begin() + 1, args.end());
+
+	if(args[0] == "render") {
+		return render(argsp);
+	} else if(args[0] == "load") {
+		return load(argsp);
+	} else if(args[0] == "select") {
+		return select(argsp);
+	} else if(args[0] == "metadata") {
+		return metadata(argsp);
+	} else if(args[0] == "enumerate") {
+		return enumerate(argsp);
+	} else if(args[0] == "clipboard") {
+		return clipboard(argsp);
+	} else if(args[0] == "git") {
+		return git(argsp);
+	} else if(args[0] == "vfs") {
+		return filesystem(argsp);
+	} else if(args[0] == "dupes") {
+		return dupes(argsp);
+	} else if(args[0] == "compare") {
+		return compare(argsp);
+	}
+
+	std::cout << "unknown benchmark \"" << args[0] << "\"" << std::endl;
+	return 1;
+}
@@ -0,0 +1,25 @@
+# ifndef BENCH_H
+# define BENCH_H
+
+// benchmarks run with odyssey --bench <name> [arguments]
+class bench {
+	private:
+
+		static void print_result(std::string name, unsigned long total, int iterations, std::string extra);
+
+	public:
+
+		static int render(std::vector<std::string> args);
+		static int load(std::vector<std::string> args);
+		static int select(std::vector<std::string> args);
+		static int metadata(std::vector<std::string> args);
+		static int enumerate(std::vector<std::string> args);
+		static int clipboard(std::vector<std::string> args);
+		static int git(std::vector<std::string> args);
+		static int filesystem(std::vector<std::string> args);
+		static int dupes(std::vector<std::string> args);
+		static int compare(std::vector<std::string> args);
+		static int run(std::vector<std::string> args);
+};
+
+# endif
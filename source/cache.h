@@ -0,0 +1,571 @@
+# ifndef CACHE_H
+# define CACHE_H
+
+// a directory as it was read. names and sizes are packed into one buffer
+// and addressed by offset, so a listing is a handful of allocations no
+// matter how many entries it has and is freed as one block
+class listing {
+	private:
+
+		struct entry {
+			unsigned int name_offset;
+			unsigned int name_length;
+			unsigned int size_offset;
+			unsigned int size_length;
+			ino_t inode;
+		};
+
+		std::vector<char> buffer;
+		std::vector<entry> entries;
+
+		unsigned int append(std::string_view text) {
+			unsigned int offset = buffer.size();
+			buffer.insert(buffer.end(), text.begin(), text.end());
+			return offset;
+		}
+
+	public:
+
+		struct timespec mtime = { 0, 0 };
+		struct timespec ctime = { 0, 0 };
+		bool hidden = false;
+
+		// false if reading stopped at a limit
+		bool complete = true;
+
+		// false if the directory did not answer in time
+		bool responsive = true;
+
+		void reserve(std::size_t count, std::size_t bytes) {
+			entries.reserve(count);
+			buffer.reserve(bytes);
+		}
+
+		void add(std::string_view name, std::string_view size, ino_t inode) {
+			unsigned int name_offset = append(name);
+			unsigned int size_offset = append(size);
+			entries.push_back({ name_offset, static_cast<unsigned int>(name.length()),
+					size_offset, static_cast<unsigned int>(size.length()), inode });
+		}
+
+		std::size_t size() const {
+			return entries.size();
+		}
+
+		bool empty() const {
+			return entries.empty();
+		}
+
+		std::string_view name(std::size_t index) const {
+			return std::string_view(buffer.data() + entries[index].name_offset, entries[index].name_length);
+		}
+
+		std::string_view file_size(std::size_t index) const {
+			return std::string_view(buffer.data() + entries[index].size_offset, entries[index].size_length);
+		}
+
+		ino_t inode(std::size_t index) const {
+			return entries[index].inode;
+		}
+
+		std::string operator[](std::size_t index) const {
+			return std::string(name(index));
+		}
+
+		// index of a name or -1
+		int find(std::string_view name_) const {
+			for(std::size_t i = 0; i < entries.size(); i++) {
+				if(name(i) == name_) {
+					return i;
+				}
+			}
+			return -1;
+		}
+
+		std::size_t memory() const {
+			return buffer.capacity() + entries.capacity() * sizeof(entry);
+		}
+
+		// a copy where the given names are replaced by their entries in fresh
+		// where they are. names fresh does not have are gone, its entries
+		// that were not there before come last. directories match without
+		// their slash
+		std::shared_ptr<listing> patched(const std::unordered_set<std::string> &names, const listing &fresh) const {
+			auto base = [](std::string_view entry_name) {
+				if(!entry_name.empty() && entry_name.back() == '/') {
+					entry_name.remove_suffix(1);
+				}
+				return entry_name;
+			};
+
+			std::unordered_map<std::string_view, std::size_t> replacements;
+			for(std::size_t i = 0; i < fresh.size(); i++) {
+				replacements[base(fresh.name(i))] = i;
+			}
+
+			std::shared_ptr<listing> copy = std::make_shared<listing>();
+			copy->reserve(entries.size() + fresh.size(), buffer.size() + fresh.buffer.size());
+			copy->hidden = hidden;
+			copy->complete = complete;
+
+			for(std::size_t i = 0; i < entries.size(); i++) {
+				std::string_view entry_name = base(name(i));
+				if(names.count(std::string(entry_name)) == 0) {
+					copy->add(name(i), file_size(i), inode(i));
+					continue;
+				}
+
+				auto replacement = replacements.find(entry_name);
+				if(replacement != replacements.end()) {
+					std::size_t index = replacement->second;
+					copy->add(fresh.name(index), fresh.file_size(index), fresh.inode(index));
+					replacements.erase(replacement);
+				}
+			}
+
+			for(std::size_t i = 0; i < fresh.size(); i++) {
+				if(replacements.count(base(fresh.name(i))) != 0) {
+					copy->add(fresh.name(i), fresh.file_size(i), fresh.inode(i));
+				}
+			}
+
+			return copy;
+		}
+};
+
+static const std::shared_ptr<const listing> empty_listing = std::make_shared<listing>();
+
+// shown for a directory on a mount that hangs
+static const std::shared_ptr<const listing> unresponsive_listing = []() {
+	std::shared_ptr<listing> elements = std::make_shared<listing>();
+	elements->responsive = false;
+	return elements;
+}();
+
+// shown for a directory still being read on a mount that answers
+static const std::shared_ptr<const listing> loading_listing = []() {
+	std::shared_ptr<listing> elements = std::make_shared<listing>();
+	elements->complete = false;
+	return elements;
+}();
+
+// a directory by device and inode, the same under every path to it
+struct directory_key {
+	dev_t device;
+	ino_t inode;
+
+	bool operator==(const directory_key &other) const {
+		return device == other.device && inode == other.inode;
+	}
+};
+
+struct directory_key_hash {
+	std::size_t operator()(const directory_key &key) const {
+		return std::hash<ino_t>()(key.inode) * 31 + std::hash<dev_t>()(key.device);
+	}
+};
+
+// listings shared by every pane and tab, least recently used ones are
+// dropped past a memory budget. watched ones are kept current by
+// patching in what inotify reports, the rest is revalidated by mtime
+// and ctime, one stat per visit
+class listing_cache {
+	private:
+
+		struct cached {
+			std::shared_ptr<const listing> elements;
+			std::list<directory_key>::iterator age;
+
+			// paths it was asked for by, the first one is watched
+			std::vector<std::string> paths;
+		};
+
+		std::unordered_map<directory_key, cached, directory_key_hash> listings;
+		std::unordered_map<std::string, directory_key> paths;
+
+		// most recently used first
+		std::list<directory_key> ages;
+
+		std::size_t memory = 0;
+
+		unsigned long hits = 0;
+		unsigned long misses = 0;
+		unsigned long stale = 0;
+		unsigned long evictions = 0;
+
+		directory_watch watch;
+
+		// a read that missed its deadline. it is kept until it comes back
+		// instead of reading the directory again from the start, which
+		// would miss the deadline again for a large enough directory
+		struct late_read {
+			std::shared_ptr<listing> elements;
+			std::shared_ptr<std::atomic<bool>> finished;
+			struct timespec mtime, ctime;
+		};
+
+		std::unordered_map<std::string, late_read> late;
+
+		void erase(directory_key key) {
+			auto iterator = listings.find(key);
+			if(iterator == listings.end()) {
+				return;
+			}
+
+			watch.remove(iterator->second.paths.front());
+			for(const auto &path : iterator->second.paths) {
+				paths.erase(path);
+			}
+
+			memory -= iterator->second.elements->memory();
+			ages.erase(iterator->second.age);
+			listings.erase(iterator);
+		}
+
+		void erase(const std::string &directory) {
+			auto path = paths.find(directory);
+			if(path != paths.end()) {
+				erase(path->second);
+			}
+		}
+
+		void replace(cached &entry, std::shared_ptr<const listing> elements) {
+			memory -= entry.elements->memory();
+			memory += elements->memory();
+			entry.elements = elements;
+		}
+
+		void touch(cached &entry) {
+			ages.splice(ages.begin(), ages, entry.age);
+		}
+
+		// drops the least recently used listings until the budget fits,
+		// the one just used always stays
+		void evict() {
+			while(ages.size() > 1 && (memory > listing_cache_budget || listings.size() > max_cached_listings)) {
+				erase(ages.back());
+				evictions++;
+			}
+		}
+
+		static bool usable(const listing &elements, int limit) {
+			return elements.hidden == show_hidden
+				&& (elements.complete || elements.size() >= static_cast<std::size_t>(limit));
+		}
+
+		// a new listing with the changed names stat'ed again. rows keep
+		// their place, only names that are new are added at the end
+		void patch(const std::string &directory, const std::unordered_set<std::string> &names) {
+			auto path = paths.find(directory);
+			if(path == paths.end()) {
+				return;
+			}
+			cached &entry = listings[path->second];
+
+			struct restat {
+				int error = 0;
+				struct stat info;
+				listing fresh;
+			};
+
+			std::shared_ptr<restat> result = std::make_shared<restat>();
+			std::vector<std::string> changed;
+			for(const auto &name : names) {
+				if(name[0] != '.' || entry.elements->hidden) {
+					changed.push_back(name);
+				}
+			}
+			bool count_items = !fs_guard::remote(directory);
+
+			// a watched directory can be on a mount that hangs too, then it
+			// is read again through get
+			if(!fs_guard::run(directory, [result, directory, changed, count_items]() {
+				stats::syscalls++;
+				int directory_fd = ::open(directory.c_str(), O_RDONLY | O_DIRECTORY | O_CLOEXEC);
+				if(directory_fd == -1 || fstat(directory_fd, &result->info) != 0) {
+					result->error = errno;
+					if(directory_fd != -1) {
+						close(directory_fd);
+					}
+					return;
+				}
+
+				std::vector<const char*> batch;
+				for(const auto &name : changed) {
+					batch.push_back(name.c_str());
+				}
+
+				std::vector<struct statx> results;
+				std::vector<int> errors;
+				stat_batch::run(directory_fd, batch, AT_STATX_DONT_SYNC, STATX_TYPE | STATX_SIZE | STATX_INO, results, errors);
+
+				// names that are gone fail here and stay out
+				for(std::size_t i = 0; i < batch.size(); i++) {
+					if(errors[i] == 0) {
+						commands::add_entry(directory, batch[i], results[i], result->fresh, count_items);
+					}
+				}
+
+				close(directory_fd);
+			}) || result->error != 0) {
+				erase(directory);
+				return;
+			}
+
+			std::shared_ptr<listing> elements = entry.elements->patched(names, result->fresh);
+			elements->mtime = result->info.st_mtim;
+			elements->ctime = result->info.st_ctim;
+			replace(entry, elements);
+		}
+
+	public:
+
+		// returns the listing of a directory, only reading it when it changed.
+		// a listing is never changed once handed out, a new one replaces it
+		std::shared_ptr<const listing> get(std::string directory, int limit) {
+			auto path = paths.find(directory);
+
+			// a watched listing is current, nothing to ask the disk
+			if(path != paths.end() && watch.watching(directory)) {
+				cached &entry = listings[path->second];
+				if(usable(*entry.elements, limit)) {
+					hits++;
+					touch(entry);
+					return entry.elements;
+				}
+			}
+
+			struct stat info;
+			if(!fs_guard::stat(directory, info)) {
+				if(errno == ETIMEDOUT) {
+					return unresponsive_listing;
+				}
+				erase(directory);
+				return nullptr;
+			} else if(!S_ISDIR(info.st_mode)) {
+				erase(directory);
+				return nullptr;
+			}
+
+			directory_key key = { info.st_dev, info.st_ino };
+
+			// the path leads somewhere else now
+			if(path != paths.end() && !(path->second == key)) {
+				erase(path->second);
+			}
+
+			auto iterator = listings.find(key);
+			if(iterator != listings.end()) {
+				cached &entry = iterator->second;
+				const listing &elements = *entry.elements;
+
+				if(elements.mtime.tv_sec == info.st_mtim.tv_sec && elements.mtime.tv_nsec == info.st_mtim.tv_nsec
+				&& elements.ctime.tv_sec == info.st_ctim.tv_sec && elements.ctime.tv_nsec == info.st_ctim.tv_nsec
+				&& usable(elements, limit)) {
+
+					hits++;
+					touch(entry);
+					if(paths.emplace(directory, key).second) {
+						entry.paths.push_back(directory);
+					}
+					return entry.elements;
+				}
+
+				stale++;
+			} else {
+				misses++;
+			}
+
+			// watched before reading, so nothing can change unseen in between.
+			// inotify misses what other clients of a network mount do, those
+			// are stat'ed every time instead
+			if(iterator == listings.end() && !fs_guard::remote(directory)) {
+				watch.add(directory);
+			}
+
+			std::shared_ptr<listing> elements;
+
+			auto pending = late.find(directory);
+			if(pending != late.end()) {
+				const late_read &read = pending->second;
+				if(!read.finished->load()) {
+					return loading_listing;
+				}
+
+				// only if the directory did not change meanwhile
+				if(read.mtime.tv_sec == info.st_mtim.tv_sec && read.mtime.tv_nsec == info.st_mtim.tv_nsec
+				&& read.ctime.tv_sec == info.st_ctim.tv_sec && read.ctime.tv_nsec == info.st_ctim.tv_nsec
+				&& usable(*read.elements, limit)) {
+
+					elements = read.elements;
+				}
+				late.erase(pending);
+			}
+
+			if(elements == nullptr) {
+				// item counts of subdirectories cost a read each, too slow remotely
+				elements = std::make_shared<listing>();
+				elements->hidden = show_hidden;
+				std::shared_ptr<std::atomic<bool>> finished = std::make_shared<std::atomic<bool>>(false);
+				bool count_items = !fs_guard::remote(directory);
+
+				// a huge directory takes long on a healthy disk too, the read
+				// goes on past the deadline and only a stat after it can tell
+				std::shared_ptr<guard_job> job = fs_guard::start(directory, [elements, finished, directory, limit, count_items]() {
+					commands::read_directory(directory, limit, *elements, count_items);
+					*finished = true;
+				}, true);
+
+				if(job == nullptr) {
+					return unresponsive_listing;
+				} else if(!fs_guard::wait(directory, job)) {
+					late[directory] = { elements, finished, info.st_mtim, info.st_ctim };
+					return fs_guard::hung(directory) ? unresponsive_listing : loading_listing;
+				}
+			}
+
+			elements->mtime = info.st_mtim;
+			elements->ctime = info.st_ctim;
+			elements->hidden = show_hidden;
+
+			if(iterator == listings.end()) {
+				ages.push_front(key);
+				cached &entry = listings[key];
+				entry.elements = elements;
+				entry.age = ages.begin();
+				entry.paths.push_back(directory);
+				paths[directory] = key;
+				memory += elements->memory();
+			} else {
+				touch(iterator->second);
+				replace(iterator->second, elements);
+				if(paths.emplace(directory, key).second) {
+					iterator->second.paths.push_back(directory);
+				}
+			}
+
+			evict();
+			return elements;
+		}
+
+		// a listing that is current without asking the disk, nullptr if
+		// there is none. watched listings are the only ones known to be
+		std::shared_ptr<const listing> current(const std::string &directory, int limit) {
+			auto path = paths.find(directory);
+			if(path == paths.end() || !watch.watching(directory)) {
+				return nullptr;
+			}
+
+			cached &entry = listings[path->second];
+			if(!usable(*entry.elements, limit)) {
+				return nullptr;
+			}
+
+			hits++;
+			touch(entry);
+			return entry.elements;
+		}
+
+		// takes a listing read off the ui thread. the directory is stat'ed
+		// again, false if it changed since the read began
+		bool store(const std::string &directory, std::shared_ptr<listing> elements) {
+			struct stat info;
+			if(!fs_guard::stat(directory, info) || !S_ISDIR(info.st_mode)
+			|| elements->mtime.tv_sec != info.st_mtim.tv_sec || elements->mtime.tv_nsec != info.st_mtim.tv_nsec
+			|| elements->ctime.tv_sec != info.st_ctim.tv_sec || elements->ctime.tv_nsec != info.st_ctim.tv_nsec) {
+
+				return false;
+			}
+
+			directory_key key = { info.st_dev, info.st_ino };
+			auto path = paths.find(directory);
+			if(path != paths.end() && !(path->second == key)) {
+				erase(path->second);
+			}
+
+			auto iterator = listings.find(key);
+			if(iterator == listings.end()) {
+				if(!fs_guard::remote(directory)) {
+					watch.add(directory);
+				}
+				ages.push_front(key);
+				cached &entry = listings[key];
+				entry.elements = elements;
+				entry.age = ages.begin();
+				entry.paths.push_back(directory);
+				paths[directory] = key;
+				memory += elements->memory();
+			} else {
+				touch(iterator->second);
+				replace(iterator->second, elements);
+				if(paths.emplace(directory, key).second) {
+					iterator->second.paths.push_back(directory);
+				}
+			}
+
+			evict();
+			return true;
+		}
+
+		void invalidate(std::string directory) {
+			erase(directory);
+			late.erase(directory);
+		}
+
+		// hit rate, evictions and memory as lines for the stats command
+		std::string describe() const {
+			unsigned long total = hits + misses + stale;
+			std::ostringstream stream;
+			stream << listings.size() << " listings, "
+				<< commands::format_file_size(memory, size_precision) << "/"
+				<< commands::format_file_size(listing_cache_budget, size_precision) << ", "
+				<< hits << " hits, " << misses << " misses, " << stale << " stale ("
+				<< (total != 0 ? hits * 100 / total : 0) << "% hit), "
+				<< evictions << " evicted";
+			return stream.str();
+		}
+
+		int get_watch_fd() const {
+			return watch.get_fd();
+		}
+
+		// microseconds until changes are due, -1 without any
+		long time_left() const {
+			return watch.time_left();
+		}
+
+		// patches in what changed. without force a burst of events is
+		// waited out first so it becomes one patch. true if anything changed
+		bool apply(bool force) {
+			watch.read();
+
+			if(!watch.ready() && !(force && watch.pending())) {
+				return false;
+			}
+
+			std::unordered_map<std::string, std::unordered_set<std::string>> changes;
+			std::unordered_set<std::string> lost;
+			bool overflow;
+			watch.take(changes, lost, overflow);
+
+			// events were dropped, nothing cached can be trusted
+			if(overflow) {
+				while(!ages.empty()) {
+					erase(ages.back());
+				}
+				return true;
+			}
+
+			for(const auto &directory : lost) {
+				erase(directory);
+			}
+
+			for(const auto &change : changes) {
+				patch(change.first, change.second);
+			}
+
+			return true;
+		}
+};
+
+# endif
@@ -0,0 +1,289 @@
+# ifndef CHILDREN_H
+# define CHILDREN_H
+
+extern char **environ;
+
+// programs started from odyssey. viewers run beside it in a session of
+// their own and are reaped when SIGCHLD comes in through a signalfd,
+// programs that need the terminal get it until they exit. commands only
+// go through /bin/sh when they use something of the shell
+class child_table {
+	private:
+
+		int fd = -1;
+		sigset_t blocked;
+
+		std::unordered_map<pid_t, std::string> children;
+
+		static std::string quote(const std::string &text) {
+			return "'" + commands::find_and_replace(text, "'", "'\\''") + "'";
+		}
+
+		// true if a shell is needed to run the command
+		static bool needs_shell(const std::string &command) {
+			return command.find_first_of("|&;<>()$`\\\"'*?[#~") != std::string::npos;
+		}
+
+		// fills in the placeholders of a command: {f} is the file, {F} is
+		// every file and {i} and {n} are the position of the one to start
+		// at, counted from 0 and from 1
+		static std::string substitute(std::string text, const std::vector<std::string> &files, int index, bool quoted) {
+			std::string file = files.empty() ? "" : files[index];
+			text = commands::find_and_replace(text, "{f}", quoted ? quote(file) : file);
+			text = commands::find_and_replace(text, "{i}", std::to_string(index));
+			text = commands::find_and_replace(text, "{n}", std::to_string(index + 1));
+
+			if(quoted && text.find("{F}") != std::string::npos) {
+				std::string list;
+				for(const auto &name : files) {
+					list += (list.empty() ? "" : " ") + quote(name);
+				}
+				text = commands::find_and_replace(text, "{F}", list);
+			}
+			return text;
+		}
+
+		// argv of a command, a {F} word becomes one argument per file
+		static std::vector<std::string> arguments(const std::string &command, const std::vector<std::string> &files, int index) {
+			if(needs_shell(command)) {
+				return { "/bin/sh", "-c", substitute(command, files, index, true) };
+			}
+
+			std::vector<std::string> words, result;
+			boost::split(words, command, boost::is_any_of(" \t"), boost::token_compress_on);
+			for(const auto &word : words) {
+				if(word == "{F}") {
+					result.insert(result.end(), files.begin(), files.end());
+				} else if(word != "") {
+					result.push_back(substitute(word, files, index, false));
+				}
+			}
+			return result;
+		}
+
+		// bytes of arguments a child can be given, less what the
+		// environment and the command take. through the shell the list is
+		// a single argument, which has a limit of its own
+		static std::size_t argument_budget(const std::string &command) {
+			std::size_t total = sysconf(_SC_ARG_MAX);
+			for(char **variable = environ; *variable != nullptr; variable++) {
+				total -= std::min(total, strlen(*variable) + 1 + sizeof(char*));
+			}
+			total -= std::min(total, command.length() + 4096);
+
+			return needs_shell(command) ? std::min<std::size_t>(total, 128 * 1024 - command.length()) : total;
+		}
+
+		// the files split where a list would not fit into one argv
+		static std::vector<std::pair<std::size_t, std::size_t>> chunks(const std::string &command,
+				const std::vector<std::string> &files) {
+
+			std::vector<std::pair<std::size_t, std::size_t>> result;
+			if(files.empty()) {
+				return { { 0, 0 } };
+			} else if(command.find("{F}") == std::string::npos) {
+				for(std::size_t i = 0; i < files.size(); i++) {
+					result.push_back({ i, 1 });
+				}
+				return result;
+			}
+
+			std::size_t budget = argument_budget(command);
+			std::size_t first = 0, used = 0;
+			for(std::size_t i = 0; i < files.size(); i++) {
+				// quoted names can grow, ' becomes four bytes
+				std::size_t cost = files[i].length() * 4 + 3 + sizeof(char*);
+				if(i != first && used + cost > budget) {
+					result.push_back({ first, i - first });
+					first = i;
+					used = 0;
+				}
+				used += cost;
+			}
+			if(first < files.size()) {
+				result.push_back({ first, files.size() - first });
+			}
+			return result;
+		}
+
+		static std::vector<std::string> part(const std::vector<std::string> &files, std::pair<std::size_t, std::size_t> chunk) {
+			return std::vector<std::string>(files.begin() + chunk.first, files.begin() + chunk.first + chunk.second);
+		}
+
+		// where the file to start at is in a chunk, 0 if it is in another
+		static int start(std::pair<std::size_t, std::size_t> chunk, int index) {
+			std::size_t position = index;
+			return position >= chunk.first && position < chunk.first + chunk.second ? position - chunk.first : 0;
+		}
+
+		// errno of posix_spawnp, 0 if the child started
+		int launch(const std::vector<std::string> &argv, bool detach, pid_t &pid) {
+			if(argv.empty()) {
+				return EINVAL;
+			}
+
+			std::vector<char*> pointers;
+			for(const auto &argument : argv) {
+				pointers.push_back(const_cast<char*>(argument.c_str()));
+			}
+			pointers.push_back(nullptr);
+
+			posix_spawnattr_t attributes;
+			posix_spawnattr_init(&attributes);
+
+			// the child gets back what odyssey blocked or ignores
+			sigset_t empty, defaults;
+			sigemptyset(&empty);
+			sigemptyset(&defaults);
+			sigaddset(&defaults, SIGINT);
+			sigaddset(&defaults, SIGQUIT);
+			sigaddset(&defaults, SIGPIPE);
+			posix_spawnattr_setsigmask(&attributes, &empty);
+			posix_spawnattr_setsigdefault(&attributes, &defaults);
+
+			short flags = POSIX_SPAWN_SETSIGMASK | POSIX_SPAWN_SETSIGDEF;
+
+			posix_spawn_file_actions_t actions;
+			posix_spawn_file_actions_init(&actions);
+
+			if(detach) {
+				posix_spawn_file_actions_addopen(&actions, STDIN_FILENO, "/dev/null", O_RDONLY, 0);
+				posix_spawn_file_actions_addopen(&actions, STDOUT_FILENO, "/dev/null", O_WRONLY, 0);
+				posix_spawn_file_actions_addopen(&actions, STDERR_FILENO, "/dev/null", O_WRONLY, 0);
+# ifdef POSIX_SPAWN_SETSID
+				flags |= POSIX_SPAWN_SETSID;
+# endif
+			}
+			posix_spawnattr_setflags(&attributes, flags);
+
+			stats::syscalls++;
+			int error = posix_spawnp(&pid, pointers[0], &actions, &attributes, pointers.data(), environ);
+
+			posix_spawn_file_actions_destroy(&actions);
+			posix_spawnattr_destroy(&attributes);
+			return error;
+		}
+
+	public:
+
+		// SIGCHLD is blocked before any thread starts so only the signalfd sees it
+		child_table() {
+			sigemptyset(&blocked);
+			sigaddset(&blocked, SIGCHLD);
+			sigprocmask(SIG_BLOCK, &blocked, nullptr);
+			fd = signalfd(-1, &blocked, SFD_NONBLOCK | SFD_CLOEXEC);
+		}
+
+		~child_table() {
+			if(fd != -1) {
+				close(fd);
+			}
+		}
+
+		int get_fd() const {
+			return fd;
+		}
+
+		// starts a viewer and returns right away, its output is dropped.
+		// a command without {F} is started once per file, one with it
+		// once per argv the files fit in. errno if one could not be started
+		int spawn(const std::string &command, const std::vector<std::string> &files = {}, int index = 0) {
+			for(const auto &chunk : chunks(command, files)) {
+				std::vector<std::string> argv = arguments(command, part(files, chunk), start(chunk, index));
+
+				pid_t pid;
+				int error = launch(argv, true, pid);
+				if(error != 0) {
+					return error;
+				}
+				children[pid] = argv[0] == "/bin/sh" ? command : argv[0];
+			}
+			return 0;
+		}
+
+		// hands the terminal to a program and waits for it, one after the
+		// other if the files need several. errno if it could not be started
+		int run(const std::string &command, const std::vector<std::string> &files = {}, int index = 0) {
+			def_prog_mode();
+			endwin();
+
+			// like system, ^C and ^\ only reach the program
+			struct sigaction ignore, interrupt, quit;
+			memset(&ignore, 0, sizeof(ignore));
+			ignore.sa_handler = SIG_IGN;
+			sigaction(SIGINT, &ignore, &interrupt);
+			sigaction(SIGQUIT, &ignore, &quit);
+
+			int error = 0;
+			for(const auto &chunk : chunks(command, files)) {
+				pid_t pid;
+				error = launch(arguments(command, part(files, chunk), start(chunk, index)), false, pid);
+				if(error != 0) {
+					break;
+				}
+
+				int status;
+				while(waitpid(pid, &status, 0) == -1 && errno == EINTR);
+			}
+
+			sigaction(SIGINT, &interrupt, nullptr);
+			sigaction(SIGQUIT, &quit, nullptr);
+
+			reset_prog_mode();
+			refresh();
+			return error;
+		}
+
+		// collects children that exited, a message for each that failed
+		std::vector<std::string> reap() {
+			std::vector<std::string> failed;
+			if(fd == -1) {
+				return failed;
+			}
+
+			// one signal can stand for many children, the table is what counts
+			struct signalfd_siginfo info;
+			bool signaled = false;
+			stats::syscalls++;
+			while(::read(fd, &info, sizeof(info)) == sizeof(info)) {
+				signaled = true;
+			}
+			if(!signaled) {
+				return failed;
+			}
+
+			for(auto child = children.begin(); child != children.end();) {
+				int status;
+				stats::syscalls++;
+				pid_t pid = waitpid(child->first, &status, WNOHANG);
+
+				if(pid == 0) {
+					child++;
+					continue;
+				}
+
+				if(pid == child->first && !(WIFEXITED(status) && WEXITSTATUS(status) == 0)) {
+					failed.push_back("\"" + child->second + "\" failed ("
+							+ (WIFEXITED(status) ? "Exit status " + std::to_string(WEXITSTATUS(status))
+							: std::string(strsignal(WTERMSIG(status)))) + ")");
+				}
+				child = children.erase(child);
+			}
+
+			return failed;
+		}
+
+		// "pid name" of every child still running
+		std::string describe() const {
+			std::string result;
+			for(const auto &child : children) {
+				if(!result.empty()) {
+					result += "  ";
+				}
+				result += std::to_string(child.first) + " " + child.second;
+			}
+			return result;
+		}
+};
+
+# endif
@@ -20,44 +20,37 @@ std::string commands::combine_vector(std::vector<std::string> vector) {
 }
 
 void commands::wipe_elements(user_interface *ui) {
-	ui->set_main_elements({});
-	ui->set_main_sizes({});
-	ui->set_preview_elements({});
-	ui->set_preview_sizes({});
+	ui->set_main_elements(empty_listing);
+	ui->set_preview_elements(empty_listing);
+	ui->set_preview_lines({});
 }
 
 /* public helper functions */
 
 // turns int file size to string with character indicating file size type
 std::string commands::format_file_size(double file_size, int precision) {
-	std::stringstream stream;
-	stream << std::fixed << std::setprecision(precision);
-
 	if(file_size == -1) {
 		return "N/A";
 	}
 
-	if(file_size < 1024) {
-		stream << file_size << "B";
-	} if(file_size >= 1024 && file_size < 1048576) {
-		stream << file_size / 1024 << "K";
-	} else if(file_size >= 1048576 && file_size < 1073741824) {
-		stream << file_size / 1024 / 1024 << "M";
-	} else if(file_size >= 1073741824 && file_size < 1099511627776) {
-		stream << file_size / 1024 / 1024 / 1024 << "G";
-	} else if(file_size >= 1099511627776) {
-		stream << file_size / 1024 / 1024 / 1024 / 1024 << "T";
+	static const char units[] = { 'B', 'K', 'M', 'G', 'T' };
+
+	int unit = 0;
+	while(file_size >= 1024 && unit < 4) {
+		file_size /= 1024;
+		unit++;
 	}
 
-	return stream.str();
+	// short enough to stay inside the string, no allocation
+	char buffer[32];
+	snprintf(buffer, sizeof(buffer), "%.*f%c", precision, file_size, units[unit]);
+	return buffer;
 }
 
 double commands::file_size(std::string directory) {
-	if(boost::filesystem::exists(directory)) {
-		try {
-			return boost::filesystem::file_size(directory);
-		} catch(...) {
-		}
+	struct statx info;
+	if(vfs::current().stat(directory, info) == 0 && S_ISREG(info.stx_mode)) {
+		return info.stx_size;
 	}
 	return -1;
 }
@@ -65,99 +58,122 @@ double commands::file_size(std::string directory) {
 // gets the sum of all file sizes of directory
 double commands::file_sizes(std::string directory) {
 	double sum = 0;
-	for(auto const &entry : boost::filesystem::directory_iterator(directory)) {
-		std::string filename = entry.path().string();
-		filename = filename.substr(filename.find_last_of('/') + 1, filename.size());
 
-		if(((filename[0] != '.' && !show_hidden) || show_hidden)
-		&& boost::filesystem::exists(entry.path().string())
-		&& !boost::filesystem::is_directory(entry.path().string())) {
+	std::unique_ptr<vfs_directory> reader = vfs::current().open_directory(directory);
 
-			sum += boost::filesystem::file_size(entry.path().string());
+	// directories are known from the entry, files need their size
+	std::vector<std::string> names;
+	std::string_view filename;
+	unsigned char type;
+	ino_t inode;
+	while(reader->next(filename, type, inode)) {
+		if((filename[0] != '.' || show_hidden) && type != DT_DIR) {
+			names.emplace_back(filename);
+		}
+	}
+	reader->done_reading();
+
+	std::vector<const char*> batch;
+	std::vector<struct statx> results;
+	std::vector<int> errors;
+
+	for(std::size_t first = 0; first < names.size(); first += stat_batch_size) {
+		batch.clear();
+		for(std::size_t i = first; i < std::min(first + stat_batch_size, names.size()); i++) {
+			batch.push_back(names[i].c_str());
+		}
+
+		reader->stat(batch, 0, STATX_TYPE | STATX_SIZE, results, errors);
+		for(std::size_t i = 0; i < batch.size(); i++) {
+			if(errors[i] == 0 && S_ISREG(results[i].stx_mode)) {
+				sum += results[i].stx_size;
+			}
 		}
 	}
 	return sum;
 }
 
-std::string commands::file_owner(std::string directory) {
-	struct stat info;
-	stat(directory.c_str(), &info);
-	struct passwd *pw = getpwuid(info.st_uid);
-	struct group *gr = getgrgid(info.st_gid);
-	return std::string(pw->pw_name) + ":" + std::string(gr->gr_name);
+// gets "user:group", every id is only looked up once since the lookup
+// can go out to the network. unknown ids are shown as numbers
+std::string commands::file_owner(uid_t uid, gid_t gid) {
+	static std::unordered_map<uid_t, std::string> users;
+	static std::unordered_map<gid_t, std::string> groups;
+
+	auto user = users.find(uid);
+	if(user == users.end()) {
+		struct passwd *pw = getpwuid(uid);
+		user = users.emplace(uid, pw != nullptr ? pw->pw_name : std::to_string(uid)).first;
+	}
+
+	auto group = groups.find(gid);
+	if(group == groups.end()) {
+		struct group *gr = getgrgid(gid);
+		group = groups.emplace(gid, gr != nullptr ? gr->gr_name : std::to_string(gid)).first;
+	}
+
+	return user->second + ":" + group->second;
 }
 
 // gets how many items is in a directory
 int commands::directory_items(std::string directory) {
+	std::unique_ptr<vfs_directory> reader = vfs::current().open_directory(directory);
+
+	if(reader->error() != 0) {
+		return reader->error() == EACCES ? -1 : 0;
+	}
+
 	int sum = 0;
-	if(boost::filesystem::exists(directory)
-	&& boost::filesystem::is_directory(directory)) {
-
-		try {
-			for(auto const &entry : boost::filesystem::directory_iterator(directory)) {
-				std::string filename = entry.path().string();
-				filename = filename.substr(filename.find_last_of('/') + 1, filename.size());
-				if((filename[0] != '.' && !show_hidden) || show_hidden) {
-					sum++;
-				}
-			}
-		} catch(...) {
-			return -1;
+
+	std::string_view filename;
+	unsigned char type;
+	ino_t inode;
+	while(reader->next(filename, type, inode)) {
+		if(filename[0] != '.' || show_hidden) {
+			sum++;
 		}
 	}
 	return sum;
 }
 
-std::string commands::file_permissions(std::string directory) {
-	boost::filesystem::perms p =
-	boost::filesystem::status(directory).permissions();
-
-	std::stringstream stream;
-	
-	stream << ((p & 0400) != 0 ? "r" : "-")
-			<< ((p & 0200) != 0 ? "w" : "-")
-			<< ((p & 0100) != 0 ? "x" : "-")
-			<< ((p & 040)  != 0 ? "r" : "-")
-			<< ((p & 020)  != 0 ? "w" : "-")
-			<< ((p & 010)  != 0 ? "x" : "-")
-			<< ((p & 04)   != 0 ? "r" : "-")
-			<< ((p & 02)   != 0 ? "w" : "-")
-			<< ((p & 01)   != 0 ? "x" : "-");
+std::string commands::file_permissions(mode_t mode) {
+	static const char letters[] = "rwxrwxrwx";
 
-	return stream.str();
+	std::string permissions(9, '-');
+	for(int i = 0; i < 9; i++) {
+		if(mode & (0400 >> i)) {
+			permissions[i] = letters[i];
+		}
+	}
+	return permissions;
 }
 
-// gets file last modified time
-std::string commands::file_last_mod_time(std::string directory) {
-	struct stat info;
-	stat(directory.c_str(), &info);
-	struct tm *tm = gmtime(&(info.st_mtime));
+// gets file last modified time in local time. files modified in the same
+// minute share one conversion, so a listing costs a handful of them
+std::string commands::file_last_mod_time(time_t time) {
+	static std::unordered_map<time_t, std::string> minutes;
 
-	std::string year = std::to_string(1900 + tm->tm_year);
-	std::string month = std::to_string(tm->tm_mon);
-	std::string day = std::to_string(tm->tm_mday);
+	time_t minute = time - ((time % 60) + 60) % 60;
 
-	std::string hours = std::to_string(tm->tm_hour - 4 < 0 ?
-			24 - (tm->tm_hour - 4) * -1 : tm->tm_hour - 4);
+	auto iterator = minutes.find(minute);
+	if(iterator != minutes.end()) {
+		return iterator->second;
+	}
 
-	std::string minutes = std::to_string(tm->tm_min);
-	
-	if(std::stoi(month) < 10) {
-		month.insert(0, "0");
-	} if(std::stoi(day) < 10) {
-		day.insert(0, "0");
-	} if(std::stoi(hours) < 10) {
-		hours.insert(0, "0");
-	} if(std::stoi(minutes) < 10) {
-		minutes.insert(0, "0");
+	if(minutes.size() >= max_cached_minutes) {
+		minutes.clear();
 	}
 
-	return year + "-" + month + "-" + day + " " + hours + ":" + minutes;
+	struct tm local;
+	char buffer[32] = "";
+	if(localtime_r(&minute, &local) != nullptr) {
+		strftime(buffer, sizeof(buffer), "%Y-%m-%d %H:%M", &local);
+	}
+	return minutes[minute] = buffer;
 }
 
 // get disk free space
 double commands::free_space(std::string directory) {
-	return boost::filesystem::space("/").available;
+	return vfs::current().available(directory);
 }
 
 std::string commands::find_and_replace(std::string str, std::string search, std::string replace) {
@@ -171,15 +187,18 @@ std::string commands::find_and_replace(std::string str, std::string search, std:
 
 /* main functions */
 
-void commands::up(user_interface *ui) {
-	if(ui->get_selected()[0] > 0) {
-		set({std::to_string(ui->get_selected()[0])}, ui);
+// moves count entries at once, as far as it can
+void commands::up(int count, user_interface *ui) {
+	int target = std::max(ui->get_cursor() - std::max(count, 1), 0);
+	if(target != ui->get_cursor()) {
+		set({std::to_string(target + 1)}, ui);
 	}
 }
 
-void commands::down(user_interface *ui) {
-	if(ui->get_selected()[0] + 2 <= ui->get_main_elements().size()) {
-		set({std::to_string(ui->get_selected()[0] + 2)}, ui);
+void commands::down(int count, user_interface *ui) {
+	int target = std::min(ui->get_cursor() + std::max(count, 1), static_cast<int>(ui->get_main_elements().size()) - 1);
+	if(target > ui->get_cursor()) {
+		set({std::to_string(target + 1)}, ui);
 	}
 }
 
@@ -195,9 +214,7 @@ void commands::set(std::vector<std::string> args, user_interface *ui) {
 	}
 
 	if(sum < ui->get_main_elements().size() + 1 && sum > 0) {
-		std::vector<int> selected = ui->get_selected();
-		selected[0] = sum - 1;
-		ui->set_selected(selected);
+		ui->set_cursor(sum - 1);
 	} else {
 		ui->set_error_message("\"" + std::to_string(sum) + "\" is not in bounds");
 	}
@@ -219,7 +236,7 @@ std::string commands::get(std::vector<std::string> args, int drawx, bool locked,
 	int cursor = placeholder.length();
 
 	if(args.size() != 0 && args[0] != "-1") {
-		cursor = std::stoi(args[0]) + drawx;
+		cursor = std::stoi(args[0]);
 	}
 
 	int x = 0;
@@ -262,192 +279,297 @@ std::string commands::get(std::vector<std::string> args, int drawx, bool locked,
 	return placeholder;
 }
 
+// reads up to limit entries of a directory with their sizes
+void commands::read_directory(std::string directory, int limit, listing &elements, bool count_items) {
+	// names are gathered first, zero separated, so their metadata can be
+	// asked for in batches instead of one stat after the other
+	std::vector<char> names;
+	std::vector<unsigned int> offsets;
+	int index = 0;
+
+	std::unique_ptr<vfs_directory> reader = vfs::current().open_directory(directory);
+	if(reader->error() != 0) {
+		return;
+	}
+
+	std::string_view filename;
+	unsigned char type;
+	ino_t inode;
+	while(reader->next(filename, type, inode)) {
+		if(index > limit) {
+			elements.complete = false;
+			break;
+		}
+		index++;
+
+		if(filename[0] == '.' && !show_hidden) {
+			continue;
+		}
+
+		offsets.push_back(names.size());
+		names.insert(names.end(), filename.begin(), filename.end());
+		names.push_back('\0');
+	}
+
+	// the reader gives its buffer back before directory_items needs one
+	reader->done_reading();
+
+	elements.reserve(offsets.size(), names.size() + offsets.size() * 6);
+
+	std::vector<const char*> batch;
+	std::vector<struct statx> results;
+	std::vector<int> errors;
+
+	for(std::size_t first = 0; first < offsets.size(); first += stat_batch_size) {
+		std::size_t last = std::min(first + stat_batch_size, offsets.size());
+
+		batch.clear();
+		for(std::size_t i = first; i < last; i++) {
+			batch.push_back(names.data() + offsets[i]);
+		}
+
+		// one statx answers exists, is_directory, size and inode
+		reader->stat(batch, AT_STATX_DONT_SYNC, STATX_TYPE | STATX_SIZE | STATX_INO, results, errors);
+
+		for(std::size_t i = 0; i < batch.size(); i++) {
+			if(errors[i] == 0) {
+				add_entry(directory, batch[i], results[i], elements, count_items);
+			}
+		}
+	}
+}
+
+// appends one stat'ed name, directories get a slash and their item count
+void commands::add_entry(std::string directory, std::string_view filename, const struct statx &info,
+		listing &elements, bool count_items) {
+
+	if(S_ISDIR(info.stx_mode)) {
+		char name[NAME_MAX + 2];
+		filename.copy(name, filename.length());
+		name[filename.length()] = '/';
+
+		int items = count_items ? directory_items(directory + "/" + std::string(filename)) : -1;
+		elements.add(std::string_view(name, filename.length() + 1),
+				items != -1 ? std::to_string(items) : count_items ? "N/A" : "-", info.stx_ino);
+	} else {
+		elements.add(filename, format_file_size(S_ISREG(info.stx_mode) ? static_cast<double>(info.stx_size) : -1, size_precision), info.stx_ino);
+	}
+}
+
 // loads the file of the current directory to vectors
 void commands::load(std::vector<std::string> args, user_interface *ui) {
 	ui->clear_windows();
-	std::vector<std::string> elements = {};
-	std::vector<std::string> sizes = {};
 
 	if(args.size() != 1) {
 		return;
 	}
 
+	scoped_timer timer("load " + args[0]);
+
 	std::string directory;
 
 	if(args[0] == "main") {
-		directory = boost::filesystem::current_path().string();
+		directory = ui->get_current_path();
+	} else if(args[0] == "parent") {
+		// nothing above root or parent column hidden? exit
+		if(!show_parent || ui->get_current_path() == "/") {
+			ui->set_parent_elements(empty_listing);
+			return;
+		}
+
+		directory = boost::filesystem::path(ui->get_current_path()).parent_path().string();
 	} else if(args[0] == "preview") {
-		// if main vector empty? exit
+		// if main vector empty? exit. it stays as it is, it may still be loading
 		if(ui->get_main_elements().empty()) {
-			wipe_elements(ui);
+			ui->set_preview_elements(empty_listing);
+			ui->set_preview_lines({});
 			return;
 		}
 
-		std::string selected_filename = ui->get_main_elements()[ui->get_selected()[0]];
-		directory = selected_filename;
+		// a comparison shows the right side of the row next to it
+		std::string selected_filename = ui->get_main_elements()[ui->get_cursor()];
+		bool comparing = ui->get_compare().view(ui->get_current_path()) != nullptr;
+		directory = comparing ? ui->get_compare().right_path(selected_filename) : ui->full_path(selected_filename);
+
+		// the file is looked at and read off the ui thread, its mount may hang
+		struct preview {
+			int error = 0;
+			bool directory = false;
+			std::vector<std::string> lines;
+		};
+
+		std::shared_ptr<preview> result = std::make_shared<preview>();
+		int line_count = ui->get_lines();
+
+		if(!fs_guard::run(directory, [result, directory, line_count]() {
+			struct statx info;
+			result->error = vfs::current().stat(directory, info);
+			if(result->error != 0) {
+				return;
+			}
 
-		// if the selected filename does not exists? exit
-		if(!boost::filesystem::exists(selected_filename)) {
-			wipe_elements(ui);
+			// fifos and devices would block on open, only files are read
+			result->directory = S_ISDIR(info.stx_mode);
+			std::unique_ptr<std::istream> read = S_ISREG(info.stx_mode) ? vfs::current().open_file(directory) : nullptr;
+			if(read != nullptr) {
+				std::string line;
+				for(int i = 0; i < line_count && std::getline(*read, line); i++) {
+					stats::bytes_read += line.length() + 1;
+					result->lines.push_back(line);
+				}
+			}
+		})) {
+			ui->set_preview_elements(unresponsive_listing);
+			ui->set_preview_lines({});
 			return;
 		}
 
-		// if selected filename is a file? read file & exit
-		if(!boost::filesystem::is_directory(selected_filename)) {
-			std::ifstream read(selected_filename);
-			std::string line;
-			for(int i = 0; i < LINES && std::getline(read, line); i++) {
-				elements.push_back(line);
-			}
-			read.close();
+		// if the selected filename does not exists? exit. the right side of a comparison may not
+		if(result->error != 0 && comparing) {
+			ui->set_preview_elements(empty_listing);
+			ui->set_preview_lines({});
+			return;
+		} else if(result->error != 0) {
+			wipe_elements(ui);
+			return;
+		}
 
-			ui->set_preview_elements(elements);
-			ui->set_preview_sizes(sizes);
+		// if selected filename is a file? show its lines & exit
+		if(!result->directory) {
+			ui->set_preview_elements(empty_listing);
+			ui->set_preview_lines(std::move(result->lines));
 			return;
 		}
+	} else {
+		return;
 	}
 
-	// loop though directory add append to vector
-	int index = 0;
-
-	boost::system::error_code error;
-	for(const auto &entry : boost::filesystem::directory_iterator(directory, error)) {
-		if(args[0] == "main" && index > LINES
-		|| args[0] == "preview" && index > LINES) {
+	// every pane reads through the same cache, the preview only needs a screenful
+	std::shared_ptr<const listing> entry = ui->get_cache()->get(directory,
+			args[0] == "preview" ? ui->get_lines() : std::numeric_limits<int>::max());
 
-			break;
-		}
-
-		if(boost::filesystem::exists(entry.path().string())) {
-			std::string filename = entry.path().string();
-			filename = filename.substr(filename.find_last_of("/") + 1, filename.length());
-			if((filename[0] != '.' && !show_hidden) || (show_hidden)) {
-			if(boost::filesystem::is_directory(entry.path().string())) {
-					filename += "/";
-					int items = directory_items(entry.path().string());
-					if(items != -1) {
-						sizes.push_back(std::to_string(items));
-					} else {
-						sizes.push_back("N/A");
-					}
-				} else {
-					sizes.push_back(format_file_size(file_size(entry.path().string()), size_precision));
-				}
-				elements.push_back(filename);
-			}
-		}
-		index++;
+	if(entry == nullptr) {
+		entry = empty_listing;
 	}
-	
+
 	if(args[0] == "main") {
-		ui->set_main_elements(elements);
-		ui->set_main_sizes(sizes);
+		std::shared_ptr<const listing> differences = ui->get_compare().view(directory);
+		std::shared_ptr<const listing> duplicates = ui->get_dupes().view(directory);
+		if(differences != nullptr) {
+			entry = differences;
+		} else if(duplicates != nullptr) {
+			entry = duplicates;
+		} else if(show_tree) {
+			entry = ui->get_tree().flatten(directory, entry, *ui->get_cache());
+		}
+		ui->set_main_elements(entry);
+	} else if(args[0] == "parent") {
+		ui->set_parent_elements(entry);
 	} else if(args[0] == "preview") {
-		ui->set_preview_elements(elements);
-		ui->set_preview_sizes(sizes);
+		ui->set_preview_elements(entry);
+		ui->set_preview_lines({});
 	}
 }
 
 void commands::cd(std::vector<std::string> args, user_interface *ui) {
-	// get selected filename
-	std::string current_directory;
-	if(!ui->get_main_elements().empty()) {
-		current_directory = boost::filesystem::canonical(
-				ui->get_main_elements()[ui->get_selected()[0]]).string();
-	}
-
 	if(args.size() == 0) {
 		// not empty? cd into selected filename
 		if(!ui->get_main_elements().empty()) {
-			cd({current_directory}, ui);
+			cd({ui->full_path(ui->get_main_elements()[ui->get_cursor()])}, ui);
 		} else {
 			ui->set_error_message("Cannot change directory (In empty directory)");
 		}
 	} else {
 		std::string directory = combine_vector(args);
 
-		if(boost::filesystem::exists(directory)
-		&& boost::filesystem::is_directory(directory)) {
-
-			std::string oldpath = boost::filesystem::current_path().string();
-			std::string newpath = boost::filesystem::canonical(directory).string();
-
-			if(boost::filesystem::exists(newpath)) {
-				boost::system::error_code error;
-				boost::filesystem::current_path(newpath, error);
+		// .. and the like are resolved by name first, so leaving a hung
+		// mount does not have to ask it anything
+		boost::filesystem::path target(directory);
+		if(target.is_relative()) {
+			target = boost::filesystem::path(ui->get_current_path()) / target;
+		}
+		std::string lexical = target.lexically_normal().string();
+
+		struct resolved {
+			int error = 0;
+			bool directory = false;
+			std::string path;
+		};
+
+		std::shared_ptr<resolved> result = std::make_shared<resolved>();
+		if(!fs_guard::run(lexical, [result, lexical]() {
+			struct statx info;
+			result->error = vfs::current().stat(lexical, info);
+			if(result->error == 0) {
+				result->error = vfs::current().resolve(lexical, result->path);
+			}
+			result->directory = result->error == 0 && S_ISDIR(info.stx_mode);
+		})) {
+			ui->set_error_message("Cannot change directory \"" + directory + "\" (Unresponsive)");
+			return;
+		}
 
-				// permission error
-				if(error.value() == 13) {
-					ui->set_error_message("Cannot change directory (Permission denied)");
-					return;
-				}
+		if(result->error == 0 && result->directory) {
+			std::string oldpath = ui->get_current_path();
+			std::string newpath = result->path;
 
-				ui->set_selected(std::vector<int>{ 0 });
-
-				load({"main"}, ui);
-
-				// if directory not empty? set selected to previous selected
-				if(!ui->get_main_elements().empty()) {
-					std::vector<std::string> file_history = ui->get_file_history();
-					for(const auto &entry : std::experimental::filesystem::directory_iterator(newpath)) {
-						std::vector<std::string>::iterator iterator =
-							std::find(file_history.begin(), file_history.end(), entry.path().string());
-
-						// if current path is found in file history
-						if(iterator != file_history.end()) {
-							std::string filename = file_history[std::distance(file_history.begin(), iterator)];
-							filename = filename.substr(filename.find_last_of('/') + 1, filename.length());
-							if(boost::filesystem::exists(filename)) {
-								ui->set_selected(filename);
-							} else {
-								file_history.erase(file_history.begin()
-										+ std::distance(file_history.begin(), iterator));
-							}
-						}
-					}
-				}
+			boost::system::error_code error;
+			boost::filesystem::current_path(newpath, error);
 
-				// if oldpath contains newpath and oldpath is bigger then newpath or in root directory
-				if((std::count(oldpath.begin(), oldpath.end(), '/')
-				> std::count(newpath.begin(), newpath.end(), '/')
-				&& oldpath.substr(0, newpath.length()) == newpath)
-				|| newpath == "/") {
+			// permission error
+			if(error.value() == 13) {
+				ui->set_error_message("Cannot change directory (Permission denied)");
+				return;
+			}
 
-					if(!ui->get_main_elements().empty()) {
+			// remember where the cursor was in the directory we leave
+			if(!ui->get_main_elements().empty()) {
+				ui->get_file_history().set(oldpath, ui->get_main_elements()[ui->get_cursor()]);
+			}
 
-						std::vector<std::string> file_history = ui->get_file_history();
+			ui->set_current_path(newpath);
+			ui->get_frecency().visit(newpath);
 
-						// find paths in filehistory that contains current path & delete them
-						for(int i = 0; i < file_history.size(); i++) {
-							if(file_history[i].substr(0, file_history[i].find_last_of('/'))
-							== current_directory.substr(0, current_directory.find_last_of('/'))) {
+			ui->get_selection().clear();
+			ui->set_cursor(0);
 
-								file_history.erase(file_history.begin() + i);
-							}
-						}
+			load({"main"}, ui);
 
-						// push back the previous selected filename
-						file_history.push_back(current_directory);
-						ui->set_file_history(file_history);
-					}
+			// if directory not empty? set selected to previous selected
+			if(!ui->get_main_elements().empty()) {
+				std::string filename = ui->get_file_history().get(newpath);
 
-					// sets selected to folder we came from
-					std::string filename;
-					if(newpath == "/") {
-						filename = oldpath.substr(newpath.length(), oldpath.length());
+				if(filename != "") {
+					if(ui->get_main_elements().find(filename) != -1) {
+						ui->set_cursor(filename);
 					} else {
-						filename = oldpath.substr(newpath.length() + 1, oldpath.length());
+						ui->get_file_history().erase(newpath);
 					}
+				}
+			}
 
-					if(std::count(filename.begin(), filename.end(), '/') == 0) {
-						ui->set_selected(filename + "/");
-					} else {
-						ui->set_selected(filename.substr(0, filename.find_first_of('/')) + "/");
-					}
+			// if oldpath contains newpath and oldpath is bigger then newpath or in root directory
+			if((std::count(oldpath.begin(), oldpath.end(), '/')
+			> std::count(newpath.begin(), newpath.end(), '/')
+			&& oldpath.substr(0, newpath.length()) == newpath)
+			|| newpath == "/") {
+
+				// sets selected to folder we came from
+				std::string filename;
+				if(newpath == "/") {
+					filename = oldpath.substr(newpath.length(), oldpath.length());
+				} else {
+					filename = oldpath.substr(newpath.length() + 1, oldpath.length());
+				}
+
+				if(std::count(filename.begin(), filename.end(), '/') == 0) {
+					ui->set_cursor(filename + "/");
+				} else {
+					ui->set_cursor(filename.substr(0, filename.find_first_of('/')) + "/");
 				}
 			}
 		} else {
-			if(!boost::filesystem::exists(directory)) {
+			if(result->error != 0) {
 				ui->set_error_message(
 						"Cannot change directory \"" + directory + "\" (No such file or directory)");
 			} else {
@@ -460,24 +582,148 @@ void commands::cd(std::vector<std::string> args, user_interface *ui) {
 
 void commands::hidden(user_interface *ui) {
 	show_hidden = !show_hidden;
-	ui->set_selected(std::vector<int>{ui->get_selected()[0]});
+	ui->clear_selection();
+}
+
+void commands::parent(user_interface *ui) {
+	show_parent = !show_parent;
+}
+
+void commands::long_listing(user_interface *ui) {
+	show_long_listing = !show_long_listing;
+}
+
+void commands::git_status(user_interface *ui) {
+	show_git_status = !show_git_status;
+}
+
+void commands::tree(user_interface *ui) {
+	show_tree = !show_tree;
+}
+
+// opens or closes the directory under the cursor in place. on a file the
+// directory it is in is closed and the cursor goes back to it
+void commands::expand(user_interface *ui) {
+	if(ui->get_main_elements().empty()) {
+		ui->set_error_message("Cannot expand (In empty directory)");
+		return;
+	}
+
+	show_tree = true;
+
+	std::string name = ui->get_main_elements()[ui->get_cursor()];
+	if(name.back() != '/') {
+		std::size_t slash = name.find_last_of('/');
+		if(slash == std::string::npos) {
+			ui->set_error_message("Cannot expand \"" + name + "\" (Not a directory)");
+			return;
+		}
+		name = name.substr(0, slash + 1);
+	}
+
+	if(!ui->get_tree().toggle(ui->get_current_path(), name)) {
+		load({"main"}, ui);
+		ui->set_cursor(name);
+	}
+}
+
+// looks for duplicates below the selected elements, or the current
+// directory without any. on the groups it closes them
+void commands::dupes(user_interface *ui) {
+	duplicate_finder &finder = ui->get_dupes();
+	if(finder.view(ui->get_current_path()) != nullptr) {
+		finder.close_view();
+		return;
+	}
+
+	std::vector<std::string> paths;
+	for(int i : ui->get_selection().indices()) {
+		std::string name = ui->get_main_elements()[i];
+		if(name.back() == '/') {
+			name.pop_back();
+		}
+		paths.push_back(name);
+	}
+	if(paths.empty()) {
+		paths.push_back("");
+	}
+
+	if(!finder.start(ui->get_current_path(), paths)) {
+		ui->set_error_message("Cannot look for duplicates (Already looking)");
+		return;
+	}
+
+	ui->set_message("looking for duplicates...");
+	ui->clear_selection();
+}
+
+// replaces the selected copies of the duplicates view with links to a
+// copy of their group that is not selected
+void commands::link(user_interface *ui) {
+	duplicate_finder &finder = ui->get_dupes();
+	if(finder.view(ui->get_current_path()) == nullptr) {
+		ui->set_error_message("Cannot link (Not showing duplicates)");
+		return;
+	}
+
+	std::vector<int> selected = ui->get_selection().indices();
+	if(selected.empty()) {
+		ui->set_error_message("Cannot link (No selected elements)");
+		return;
+	}
+
+	std::unordered_set<std::string> chosen;
+	for(int i : selected) {
+		chosen.insert(ui->get_main_elements()[i]);
+	}
+
+	std::vector<std::string> linked;
+	for(int i : selected) {
+		std::string name = ui->get_main_elements()[i];
+		std::vector<std::string> group = finder.group(name);
+		auto kept = std::find_if(group.begin(), group.end(), [&chosen](const std::string &file) {
+			return chosen.count(file) == 0;
+		});
+		if(kept == group.end()) {
+			ui->set_error_message("Cannot link \"" + name + "\" (Every copy is selected)");
+			break;
+		}
+
+		// the copy is only replaced once the link exists
+		std::string temporary = name + ".odyssey-link";
+		int error = vfs::current().link(*kept, temporary);
+		if(error == 0) {
+			error = vfs::current().rename(temporary, name);
+			if(error != 0) {
+				vfs::current().remove(temporary);
+			}
+		}
+
+		if(error != 0) {
+			ui->set_error_message("Cannot link \"" + name + "\" (" + strerror(error) + ")");
+			break;
+		}
+		linked.push_back(name);
+	}
+
+	finder.forget(linked);
+	ui->clear_selection();
 }
 
 void commands::mkdir(std::vector<std::string> args, user_interface *ui) {
 	std::string filename = combine_vector(args);
 
-	if(!boost::filesystem::exists(filename)) {
-		boost::system::error_code error;
-		boost::filesystem::create_directory(filename, error);
+	if(!vfs::current().exists(filename)) {
+		int error = vfs::current().make_directory(filename);
 
-		if(error.value() == 13) {
-			ui->set_error_message("Cannot create directory (Permission denied)");
+		if(error != 0) {
+			ui->set_error_message("Cannot create directory (" + std::string(strerror(error)) + ")");
 			return;
 		}
 
-		ui->set_selected(std::vector<int>{ui->get_selected()[0]});
+		ui->clear_selection();
 	} else { 
-		if(boost::filesystem::is_directory(filename)) {
+		if(vfs::current().is_directory(filename)) {
 			ui->set_error_message("Cannot create directory \"" + filename + "\" (Directory exists)");
 		} else {
 			ui->set_error_message("Cannot create directory \"" + filename + "\" (File exists)");
@@ -486,10 +732,85 @@ void commands::mkdir(std::vector<std::string> args, user_interface *ui) {
 }
 
 // cd if directory otherwise opens file
+// the opener of a file by its extension
+static struct open find_opener(std::string filename) {
+	std::string extension = boost::filesystem::path(filename).extension().string();
+
+	for(int j = 0; j < open_map.size(); j++) {
+		if(extension == open_map[j].extension) {
+			return open_map[j];
+		}
+	}
+	return { "", default_opener, true };
+}
+
+// opens files grouped by their opener, each group in as few processes
+// as its command allows. the group holding files[index] starts at it
+void commands::open_files(std::vector<std::string> files, int index, user_interface *ui) {
+	std::vector<struct open> openers;
+	std::vector<std::vector<std::string>> groups;
+	std::vector<int> starts;
+
+	for(int i = 0; i < files.size(); i++) {
+		struct open opener = find_opener(files[i]);
+
+		int group = 0;
+		while(group < openers.size() && openers[group].command != opener.command) {
+			group++;
+		}
+		if(group == openers.size()) {
+			openers.push_back(opener);
+			groups.emplace_back();
+			starts.push_back(0);
+		}
+
+		if(i == index) {
+			starts[group] = groups[group].size();
+		}
+		groups[group].push_back(files[i]);
+	}
+
+	// viewers run beside odyssey, editors get the terminal
+	child_table &children = ui->get_children();
+	for(int i = 0; i < groups.size(); i++) {
+		int error = openers[i].terminal ? children.run(openers[i].command, groups[i], starts[i])
+			: children.spawn(openers[i].command, groups[i], starts[i]);
+
+		if(error != 0) {
+			ui->set_error_message("Cannot open \"" + groups[i].front() + "\" with \""
+					+ openers[i].command + "\" (" + strerror(error) + ")");
+			return;
+		}
+	}
+}
+
 void commands::open(std::vector<std::string> args, user_interface *ui) {
 	if(args.size() == 0) {
-		if(!ui->get_main_elements().empty()) {
-			open({ui->get_main_elements()[ui->get_selected()[0]]}, ui);
+		if(!ui->get_selection().empty()) {
+			// the whole selection at once, starting at the cursor if it is in it
+			std::vector<int> selected = ui->get_selection().indices();
+			std::vector<std::string> files;
+			int index = 0;
+
+			for(int i : selected) {
+				if(ui->get_main_elements().name(i).back() == '/') {
+					continue;
+				}
+				if(i == ui->get_cursor()) {
+					index = files.size();
+				}
+				files.push_back(ui->full_path(ui->get_main_elements()[i]));
+			}
+
+			if(files.empty()) {
+				ui->set_error_message("Cannot open (No selected files)");
+				return;
+			}
+
+			ui->clear_selection();
+			open_files(files, index, ui);
+		} else if(!ui->get_main_elements().empty()) {
+			open({ui->get_main_elements()[ui->get_cursor()]}, ui);
 		} else {
 			ui->set_error_message("Cannot open (In empty directory)");
 			return;
@@ -497,26 +818,11 @@ void commands::open(std::vector<std::string> args, user_interface *ui) {
 	} else {
 		std::string filename = combine_vector(args);
 
-		if(boost::filesystem::exists(filename)) {
-			if(boost::filesystem::is_directory(filename)) {
+		if(vfs::current().exists(filename)) {
+			if(vfs::current().is_directory(filename)) {
 				cd({filename}, ui);
 			} else {
-				boost::filesystem::path filename_obj(
-						boost::filesystem::canonical(filename));
-
-				for(int j = 0; j < open_map.size(); j++) {
-					if(filename_obj.extension().string() == open_map[j].extension) {
-						std::string command = open_map[j].command;
-						filename = find_and_replace(filename, "\"", "\\\"");
-						command = find_and_replace(command, "{f}", "\"" + filename + "\"");
-						system(command.c_str());
-						return;
-					}
-				}
-
-				// if file extension not found it will open file with vim
-				filename = find_and_replace(filename, "\"", "\\\"");
-				system(std::string("vim \"" + filename + "\"").c_str());
+				open_files({ filename }, 0, ui);
 			}
 		} else {
 			ui->set_error_message("Cannot open \"" + filename + "\" (No such file or directory)");
@@ -524,35 +830,174 @@ void commands::open(std::vector<std::string> args, user_interface *ui) {
 	}
 }
 
+// opens every file of the directory that has the opener of the one
+// under the cursor in one viewer, started at the cursor
+void commands::playlist(user_interface *ui) {
+	const listing &elements = ui->get_main_elements();
+	if(elements.empty() || elements.name(ui->get_cursor()).back() == '/') {
+		ui->set_error_message("Cannot play (No file under the cursor)");
+		return;
+	}
+
+	std::string command = find_opener(elements[ui->get_cursor()]).command;
+
+	std::vector<std::string> files;
+	int index = 0;
+	for(int i = 0; i < elements.size(); i++) {
+		if(elements.name(i).back() == '/' || find_opener(elements[i]).command != command) {
+			continue;
+		}
+		if(i == ui->get_cursor()) {
+			index = files.size();
+		}
+		files.push_back(ui->full_path(elements[i]));
+	}
+
+	open_files(files, index, ui);
+}
+
+// the path of an existing file without symlinks, the name itself if
+// it cannot be resolved
+static std::string resolved(std::string path) {
+	std::string result;
+	return vfs::current().resolve(path, result) == 0 ? result : path;
+}
+
+// the absolute path of a file that may not exist yet
+static std::string absolute(std::string path) {
+	return boost::filesystem::absolute(path).lexically_normal().string();
+}
+
+// compares the current directory with another, without one it stops
+// showing the last comparison
+void commands::compare(std::vector<std::string> args, user_interface *ui) {
+	directory_compare &comparison = ui->get_compare();
+	std::string other = combine_vector(args);
+
+	if(other == "") {
+		if(comparison.view(ui->get_current_path()) == nullptr) {
+			ui->set_error_message("Cannot compare (No directory)");
+		}
+		comparison.close_view();
+		return;
+	}
+
+	if(!vfs::current().is_directory(other)) {
+		ui->set_error_message("Cannot compare with \"" + other + "\" (Not a directory)");
+		return;
+	}
+
+	std::string left = ui->get_current_path(), right = resolved(other);
+	if(right == left) {
+		ui->set_error_message("Cannot compare with \"" + other + "\" (Same directory)");
+		return;
+	}
+
+	comparison.start(left, right);
+	ui->set_message(comparison.describe());
+	ui->clear_selection();
+}
+
+// makes the right side of a comparison like the left for the selected
+// rows, or all of them. what is only on the right is left alone
+void commands::sync(user_interface *ui) {
+	directory_compare &comparison = ui->get_compare();
+	if(comparison.view(ui->get_current_path()) == nullptr) {
+		ui->set_error_message("Cannot sync (Not comparing)");
+		return;
+	} else if(comparison.is_running()) {
+		ui->set_error_message("Cannot sync (Still comparing)");
+		return;
+	}
+
+	std::vector<int> rows = ui->get_selection().indices();
+	if(rows.empty()) {
+		for(int i = 0; i < ui->get_main_elements().size(); i++) {
+			rows.push_back(i);
+		}
+	}
+
+	// ask for comfirmation
+	mvprintw(LINES - 1, 0, "are you sure > ");
+	std::string choice = get({"-1", ""}, 15, true, ui);
+	if(choice != "y") {
+		ui->set_message("ignored.");
+		return;
+	}
+
+	std::vector<std::string> synced;
+	int skipped = 0;
+	for(int i : rows) {
+		std::string name = ui->get_main_elements()[i];
+		compare_state state = comparison.state(name);
+		if(state != COMPARE_LEFT && state != COMPARE_DIFFERS) {
+			skipped++;
+			continue;
+		}
+
+		// copied next to where it goes first, so a failed copy changes nothing
+		std::string from = comparison.left_path(name), to = comparison.right_path(name);
+		std::string temporary = to + ".odyssey-sync";
+		std::string failed;
+		int error = vfs::current().copy_all(from, temporary, failed);
+
+		if(error == 0) {
+			// rename only replaces a file with a file or an empty directory
+			// with a directory, so anything else in the way goes first
+			struct statx copied, existing;
+			if(vfs::current().stat(to, existing, false) == 0 &&
+					(S_ISDIR(existing.stx_mode) || vfs::current().stat(temporary, copied, false) != 0 ||
+					(copied.stx_mode & S_IFMT) != (existing.stx_mode & S_IFMT))) {
+				error = vfs::current().remove_all(to, failed);
+			}
+			if(error == 0) {
+				error = vfs::current().rename(temporary, to);
+				failed = to;
+			}
+		}
+
+		if(error != 0) {
+			std::string ignored;
+			vfs::current().remove_all(temporary, ignored);
+			comparison.forget(synced);
+			ui->set_error_message("Cannot sync \"" + failed + "\" (" + strerror(error) + ")");
+			return;
+		}
+		synced.push_back(name);
+	}
+
+	comparison.forget(synced);
+	ui->clear_selection();
+	ui->set_message("synced " + std::to_string(synced.size()) + ", left " + std::to_string(skipped) + " alone.");
+}
+
 void commands::move_file(std::vector<std::string> args, user_interface *ui) {
 	if(args.size() == 0) {
-		std::vector<int> selected = ui->get_selected();
-		std::string selected_filename = ui->get_main_elements()[selected[0]];
+		std::vector<int> selected = ui->get_selection().indices();
+		std::string selected_filename = ui->get_main_elements()[ui->get_cursor()];
 
 		// have selected elements
-		if(ui->get_selected().size() != 1) {
-			if(boost::filesystem::exists(selected_filename)
-			&& boost::filesystem::is_directory(selected_filename)) {
+		if(!selected.empty()) {
+			if(vfs::current().is_directory(selected_filename)) {
 
 				// loop though selected and move elements to selected filename
-				for(int i = 1; i < selected.size(); i++) {
-					boost::system::error_code error;
-					boost::filesystem::rename(ui->get_main_elements()[selected[i]],
-							selected_filename + ui->get_main_elements()[selected[i]], error);
+				for(int i = 0; i < selected.size(); i++) {
+					int error = vfs::current().rename(ui->get_main_elements()[selected[i]],
+							selected_filename + ui->get_main_elements()[selected[i]]);
 
 					// permission errors
-					if(error.value() == 13) {
+					if(error == EACCES) {
 						ui->set_error_message("Cannot move (Permission denied)");
 						return;
 					}
 
 					// subdirectory errors
-					if(error.value() == 22) {
+					if(error == EINVAL) {
 						ui->set_error_message("Cannot move \"" + ui->get_main_elements()[selected[i]] + "\" into a subdirectory of itself");
 						return;
 					}
 				}
-				ui->set_selected(std::vector<int>{ui->get_selected()[0]});
+				ui->clear_selection();
 			} else {
 				ui->set_error_message("Cannot move to \"" + selected_filename + "\" (Not a directory)");
 			}
@@ -567,20 +1012,18 @@ void commands::move_file(std::vector<std::string> args, user_interface *ui) {
 			return;
 		}
 
-		if(boost::filesystem::exists(filename)
-		&& boost::filesystem::is_directory(filename)) {
+		if(vfs::current().is_directory(filename)) {
 			
-			std::vector<int> selected = ui->get_selected();
+			std::vector<int> selected = ui->get_selection().indices();
 
 			// loop through and move
-			for(int i = 1; i < selected.size(); i++) {
-				boost::filesystem::path base_path(boost::filesystem::canonical(ui->get_main_elements()[selected[i]]));
-				std::string target_path = boost::filesystem::canonical(filename).string()
-					+ "/" + base_path.filename().string();
+			for(int i = 0; i < selected.size(); i++) {
+				boost::filesystem::path base_path(resolved(ui->get_main_elements()[selected[i]]));
+				std::string target_path = resolved(filename) + "/" + base_path.filename().string();
 
 				// file already exists error
-				if(boost::filesystem::exists(target_path)) {
-					if(boost::filesystem::is_directory(target_path)) {
+				if(vfs::current().exists(target_path)) {
+					if(vfs::current().is_directory(target_path)) {
 						ui->set_error_message("Cannot move \"" + target_path + "\" (directory exists)");
 					} else {
 						ui->set_error_message("Cannot move \"" + target_path + "\" (file exists)");
@@ -588,30 +1031,27 @@ void commands::move_file(std::vector<std::string> args, user_interface *ui) {
 					return;
 				}
 
-				boost::system::error_code error;
-				boost::filesystem::rename(base_path, target_path, error);
+				int error = vfs::current().rename(base_path.string(), target_path);
 
 				// permission errors
-				if(error.value() == 13) {
+				if(error == EACCES) {
 					ui->set_error_message("Cannot move \"" + base_path.string() + "\" (Permission denied)");
 					return;
 				}
 
 				// subdirectory errors
-				if(error.value() == 22) {
+				if(error == EINVAL) {
 					ui->set_error_message("Cannot move \"" + ui->get_main_elements()[selected[i]] + "\" into a subdirectory of itself");
 					return;
 				}
 			}
 
-			ui->set_selected(std::vector<int>{ui->get_selected()[0]});
-		} else if(!boost::filesystem::exists(filename)) {
-			boost::system::error_code error;
-			boost::filesystem::rename(boost::filesystem::canonical(ui->get_main_elements()[ui->get_selected()[0]]),
-					boost::filesystem::weakly_canonical(filename), error);
+			ui->clear_selection();
+		} else if(!vfs::current().exists(filename)) {
+			int error = vfs::current().rename(resolved(ui->get_main_elements()[ui->get_cursor()]), absolute(filename));
 
 			// permission errors
-			if(error.value() == 13) {
+			if(error == EACCES) {
 				ui->set_error_message("Cannot move \"" + filename + "\" (Permission denied)");
 				return;
 			}
@@ -621,19 +1061,19 @@ void commands::move_file(std::vector<std::string> args, user_interface *ui) {
 
 void commands::rename(std::vector<std::string> args, user_interface *ui) {
 	boost::filesystem::path selected_filename(
-			ui->get_main_elements()[ui->get_selected()[0]]);
+			ui->get_main_elements()[ui->get_cursor()]);
 	mvprintw(LINES - 1, 0, ":");
 	process_command(get({"2", "mv", selected_filename.extension().string()}, 1, false, ui), ui);
 }
 
 void commands::begin_move(std::vector<std::string> args, user_interface *ui) {
 	mvprintw(LINES - 1, 0, ":");
-	process_command(get({"2", "mv", ui->get_main_elements()[ui->get_selected()[0]]}, 1, false, ui), ui);
+	process_command(get({"2", "mv", ui->get_main_elements()[ui->get_cursor()]}, 1, false, ui), ui);
 }
 
 void commands::end_move(std::vector<std::string> args, user_interface *ui) {
 	boost::filesystem::path selected_filename(
-				ui->get_main_elements()[ui->get_selected()[0]]);
+				ui->get_main_elements()[ui->get_cursor()]);
 
 	int begin_at = 2 + (selected_filename.string().length() -
 			selected_filename.extension().string().length());
@@ -644,9 +1084,10 @@ void commands::end_move(std::vector<std::string> args, user_interface *ui) {
 
 void commands::remove(std::vector<std::string> args, user_interface *ui) {
 	if(args.size() == 0) {
-		std::vector<int> selected = ui->get_selected();
-		if(selected.size() == 1) {
+		std::vector<int> selected = ui->get_selection().indices();
+		if(selected.empty()) {
 			ui->set_error_message("Cannot remove (No selected elements)");
+			return;
 		}
 
 		// ask for comfirmation
@@ -657,19 +1098,22 @@ void commands::remove(std::vector<std::string> args, user_interface *ui) {
 			return;
 		}
 
-		for(int i = 1; i < selected.size(); i++) {
-			boost::system::error_code error;
-			boost::filesystem::remove_all(ui->get_main_elements()[selected[i]], error);
+		std::vector<std::string> removed;
+		for(int i = 0; i < selected.size(); i++) {
+			std::string failed;
+			int error = vfs::current().remove_all(ui->get_main_elements()[selected[i]], failed);
 
-			// permission errors
-			if(error.value() == 13) {
-				ui->set_error_message("Cannot remove \"" + ui->get_main_elements()[selected[i]] + "\" (Permission denied)");
+			if(error != 0) {
+				ui->get_dupes().forget(removed);
+				ui->set_error_message("Cannot remove \"" + failed + "\" (" + strerror(error) + ")");
 				return;
 			}
+			removed.push_back(ui->get_main_elements()[selected[i]]);
 		}
+		ui->get_dupes().forget(removed);
 	} else {
 		std::string filename = combine_vector(args);
-		if(boost::filesystem::exists(filename)) {
+		if(vfs::current().exists(filename)) {
 			// ask for comfirmation
 			mvprintw(LINES - 1, 0, "are you sure > ");
 			std::string choice = get({"-1", ""}, 15, true, ui);
@@ -678,37 +1122,36 @@ void commands::remove(std::vector<std::string> args, user_interface *ui) {
 				return;
 			}
 
-			boost::system::error_code error;
-			boost::filesystem::remove_all(boost::filesystem::canonical(filename), error);
+			std::string failed;
+			int error = vfs::current().remove_all(resolved(filename), failed);
 
-			// permission errors
-			if(error.value() == 13) {
-				ui->set_error_message("Cannot remove \"" + boost::filesystem::canonical(filename).string() + "\" (Permission denied)");
+			if(error != 0) {
+				ui->set_error_message("Cannot remove \"" + failed + "\" (" + strerror(error) + ")");
 				return;
 			}
+			ui->get_dupes().forget({filename});
 		} else {
 			ui->set_error_message("Cannot remove \"" + filename + "\" (No such file or directory)");
 			return;
 		}
 	}
 
-	ui->set_selected(std::vector<int>{ui->get_selected()[0]});
+	ui->clear_selection();
 }
 
 void commands::touch(std::vector<std::string> args, user_interface *ui) {
 	std::string filename = combine_vector(args);
-	if(!boost::filesystem::exists(filename)) {
-		std::ofstream write(filename);
-		write.close();
+	if(!vfs::current().exists(filename)) {
+		int error = vfs::current().create_file(filename);
 
-		if(write.fail()) {
-			ui->set_error_message("Cannot create file \"" + filename + "\" (Permissions denied)");
+		if(error != 0) {
+			ui->set_error_message("Cannot create file \"" + filename + "\" (" + strerror(error) + ")");
 			return;
 		}
 
-		ui->set_selected(std::vector<int>{ui->get_selected()[0]});
+		ui->clear_selection();
 	} else {
-		if(boost::filesystem::is_directory(filename)) {
+		if(vfs::current().is_directory(filename)) {
 			ui->set_error_message("Cannot create file \"" + filename + "\" (Directory exists)");
 		} else {
 			ui->set_error_message("Cannot create file \"" + filename + "\" (File exists)");
@@ -716,54 +1159,147 @@ void commands::touch(std::vector<std::string> args, user_interface *ui) {
 	}
 }
 
-void commands::select(std::vector<std::string> args, user_interface *ui) {
-	std::vector<int> selected = ui->get_selected();
-	std::vector<int>::iterator iterator = std::find(selected.begin() + 1, selected.end(), selected[0]);
+// toggles count entries from the cursor on and moves past them
+void commands::select(int count, user_interface *ui) {
+	if(ui->get_main_elements().empty()) {
+		return;
+	}
 
-	if(iterator != selected.end()) {
-		selected.erase(selected.begin() + std::distance(selected.begin(), iterator));
-	} else {
-		selected.push_back(selected[0]);
+	count = std::max(count, 1);
+	for(int i = ui->get_cursor(); i < ui->get_cursor() + count && i < ui->get_main_elements().size(); i++) {
+		ui->get_selection().toggle(i);
+	}
+
+	ui->set_cursor(ui->get_cursor() + count);
+}
+
+void commands::select_all(user_interface *ui) {
+	ui->get_selection().set_all();
+}
+
+void commands::invert(user_interface *ui) {
+	ui->get_selection().invert();
+}
+
+void commands::unselect(user_interface *ui) {
+	ui->get_selection().clear();
+}
+
+// marks entries from the first to the last position, both counted from 1
+void commands::select_range(std::vector<std::string> args, user_interface *ui) {
+	if(args.size() != 2 || !is_digit(args[0]) || !is_digit(args[1])
+	|| args[0] == "" || args[1] == "") {
+
+		ui->set_error_message("Cannot select range (Expected two positions)");
+		return;
+	}
+
+	int first = std::stoi(args[0]);
+	int last = std::stoi(args[1]);
+
+	if(first < 1 || last < first || last > ui->get_main_elements().size()) {
+		ui->set_error_message("\"" + args[0] + " " + args[1] + "\" is not in bounds");
+		return;
 	}
 
-	if(selected[0] != ui->get_main_elements().size()) {
-		selected[0]++;
+	ui->get_selection().set_range(first - 1, last - 1);
+}
+
+// marks entries whose name matches a glob or an extended regex
+void commands::select_pattern(std::vector<std::string> args, bool regex, user_interface *ui) {
+	std::string pattern = combine_vector(args);
+
+	if(pattern == "") {
+		ui->set_error_message("Cannot select (No pattern)");
+		return;
 	}
 
-	ui->set_selected(selected);
+	regex_t compiled;
+	if(regex && regcomp(&compiled, pattern.c_str(), REG_EXTENDED | REG_NOSUB) != 0) {
+		ui->set_error_message("Cannot select \"" + pattern + "\" (Invalid regex)");
+		return;
+	}
+
+	const listing &elements = ui->get_main_elements();
+	selection &marks = ui->get_selection();
+
+	// names are matched without the slash directories carry
+	char name[NAME_MAX + 2];
+	for(std::size_t i = 0; i < elements.size(); i++) {
+		std::string_view element = elements.name(i);
+		if(element.back() == '/') {
+			element.remove_suffix(1);
+		}
+
+		element.copy(name, element.length());
+		name[element.length()] = '\0';
+
+		if(regex ? regexec(&compiled, name, 0, nullptr, 0) == 0 : fnmatch(pattern.c_str(), name, 0) == 0) {
+			marks.set(i, true);
+		}
+	}
+
+	if(regex) {
+		regfree(&compiled);
+	}
+}
+
+// the register a command names, the unnamed one without an argument
+static bool register_name(std::vector<std::string> args, std::string action, char &name, user_interface *ui) {
+	name = args.empty() ? '"' : args[0].length() == 1 ? args[0][0] : '\0';
+
+	if(!registers::valid(name)) {
+		ui->set_error_message("Cannot " + action + " (No register \"" + args[0] + "\")");
+		return false;
+	}
+	return true;
 }
 
 void commands::copy_directory(user_interface *ui) {
-	std::string filename = boost::filesystem::current_path().string();
-	filename = find_and_replace(filename, "\"", "\\\"");
-	system(std::string("echo \"" + filename
-				+ "\" | xclip -selection clipboard").c_str());
+	if(!ui->get_registers().yank('"', { ui->get_current_path() })) {
+		ui->set_error_message("Cannot export \"" + ui->get_current_path() + "\" to the clipboard");
+	}
 }
 
-void commands::copy(std::vector<std::string> args, user_interface *ui) {
-	if(args.size() == 0) {
-		if(ui->get_selected().size() != 1) {
-			// copy file paths to xclip
-			std::string command = "";
-			std::vector<int> selected = ui->get_selected();
-			for(int i = 1; i < selected.size(); i++) {
-				command += boost::filesystem::absolute(ui->get_main_elements()[selected[i]]).string();
-				if(command.back() == '/') {
-					command.pop_back();
-				}
+// puts the absolute paths of the selected files, or of the one under the
+// cursor, into a register
+void commands::yank(std::vector<std::string> args, user_interface *ui) {
+	char name;
+	if(!register_name(args, "yank", name, ui)) {
+		return;
+	}
 
-				if(i != selected.size() - 1) {
-					command += "\\n";
-				}
-			}
-			ui->set_selected(std::vector<int>{ui->get_selected()[0]});
-			command += "\" | xclip -selection clipboard";
-			command.insert(0, "echo -e \"");
-			system(command.c_str());
-			ui->set_message("copyed.");
-		} else {
-			ui->set_error_message("Cannot copy (No selected elements)");
+	std::vector<std::string> paths;
+	if(!ui->get_selection().empty()) {
+		std::vector<int> selected = ui->get_selection().indices();
+		paths.reserve(selected.size());
+		for(int i : selected) {
+			paths.push_back(ui->full_path(ui->get_main_elements()[i]));
 		}
+		ui->clear_selection();
+	} else if(!ui->get_main_elements().empty()) {
+		paths.push_back(ui->full_path(ui->get_main_elements()[ui->get_cursor()]));
+	} else {
+		ui->set_error_message("Cannot yank (No elements)");
+		return;
+	}
+
+	std::size_t count = paths.size();
+	if(!ui->get_registers().yank(name, std::move(paths))) {
+		ui->set_error_message("Cannot export " + std::to_string(count) + " paths to the clipboard");
+		return;
+	}
+	ui->set_message("yanked " + std::to_string(count) + (count == 1 ? " path." : " paths."));
+}
+
+void commands::show_registers(user_interface *ui) {
+	std::string description = ui->get_registers().describe();
+	ui->set_message(description == "" ? "no registers." : description);
+}
+
+void commands::copy(std::vector<std::string> args, user_interface *ui) {
+	if(args.size() == 0) {
+		yank(args, ui);
 	} else {
 		std::string filename = combine_vector(args);
 
@@ -772,20 +1308,19 @@ void commands::copy(std::vector<std::string> args, user_interface *ui) {
 			return;
 		}
 
-		if(boost::filesystem::exists(filename)
-		&& boost::filesystem::is_directory(filename)) {
+		if(vfs::current().is_directory(filename)) {
 
-			std::vector<int> selected = ui->get_selected();
+			std::vector<int> selected = ui->get_selection().indices();
 
-			if(selected.size() == 1) {
+			if(selected.empty()) {
 				ui->set_error_message("Cannot copy (No selected elements)");
 				return;
 			}
 
 			// does the copying
-			for(int i = 1; i < selected.size(); i++) {
-				boost::filesystem::path base_path(boost::filesystem::canonical(ui->get_main_elements()[selected[i]]));
-				boost::filesystem::path target_path(boost::filesystem::canonical(filename).string() + "/" + base_path.filename().string());
+			for(int i = 0; i < selected.size(); i++) {
+				boost::filesystem::path base_path(resolved(ui->get_main_elements()[selected[i]]));
+				boost::filesystem::path target_path(resolved(filename) + "/" + base_path.filename().string());
 
 				// subdirectory error
 				if(target_path.string().substr(0, base_path.string().length()) == base_path.string()) {
@@ -794,8 +1329,8 @@ void commands::copy(std::vector<std::string> args, user_interface *ui) {
 				}
 
 				// exists error
-				if(boost::filesystem::exists(target_path)) {
-					if(boost::filesystem::is_directory(target_path)) {
+				if(vfs::current().exists(target_path.string())) {
+					if(vfs::current().is_directory(target_path.string())) {
 						ui->set_error_message("Cannot copy \"" + base_path.string() + "\" (Directory exists)");
 					} else {
 						ui->set_error_message("Cannot copy \"" + base_path.string() + "\" (File exists)");
@@ -803,58 +1338,47 @@ void commands::copy(std::vector<std::string> args, user_interface *ui) {
 					return;
 				}
 
-				std::error_code error;
-				std::experimental::filesystem::copy(base_path.string(),
-						target_path.string(), std::experimental::filesystem::copy_options::recursive, error);
+				std::string failed;
+				int error = vfs::current().copy_all(base_path.string(), target_path.string(), failed);
 
-				// permission error
-				if(error.value() == 13) {
-					ui->set_error_message("Cannot copy to \"" + target_path.string() + "\" {Permission denied)");
+				if(error != 0) {
+					ui->set_error_message("Cannot copy to \"" + failed + "\" (" + strerror(error) + ")");
 					return;
 				}
 			}
-			ui->set_selected(std::vector<int>{ui->get_selected()[0]});
-		} else if(!boost::filesystem::exists(filename)) {
-			std::error_code error;
-			std::experimental::filesystem::copy(ui->get_main_elements()[ui->get_selected()[0]],
-					boost::filesystem::weakly_canonical(filename).string(),
-					std::experimental::filesystem::copy_options::recursive, error);
+			ui->clear_selection();
+		} else if(!vfs::current().exists(filename)) {
+			std::string failed;
+			int error = vfs::current().copy_all(ui->get_main_elements()[ui->get_cursor()], absolute(filename), failed);
 
-			// permission errors
-			if(error.value() == 13) {
-				ui->set_error_message("Cannot copy \"" + ui->get_main_elements()[ui->get_selected()[0]] + "\" (Permission denied)");
+			if(error != 0) {
+				ui->set_error_message("Cannot copy \"" + failed + "\" (" + strerror(error) + ")");
 				return;
 			}
 		}
 	}
 }
 
-void commands::paste(user_interface *ui) {
-	std::array<char, 128> buffer;
-	std::string result;
-	std::unique_ptr<FILE, decltype(&pclose)> pipe(popen("xclip -selection clipboard -o", "r"), pclose);
-	
-	if(!pipe) {
-		quit({"popen() failed"});
+void commands::paste(std::vector<std::string> args, user_interface *ui) {
+	char name;
+	if(!register_name(args, "paste", name, ui)) {
+		return;
 	}
 
-	while(fgets(buffer.data(), buffer.size(), pipe.get()) != nullptr) {
-		result += buffer.data();
+	std::vector<std::string> paths = ui->get_registers().get(name);
+	if(paths.empty()) {
+		ui->set_error_message("Cannot paste (Register \"" + std::string(1, name) + "\" is empty)");
+		return;
 	}
 
-	std::stringstream stream(result);
-	std::string line;
-
-	stream = std::stringstream(result);
-	
 	// do the copying
-	while(std::getline(stream, line, '\n')) {
-		std::string target = boost::filesystem::current_path().string()
+	for(const std::string &line : paths) {
+		std::string target = ui->get_current_path()
 				+ "/" + line.substr(line.find_last_of("/") + 1, line.length());
 
 		// exists error
-		if(boost::filesystem::exists(target)) {
-			if(boost::filesystem::is_directory(target)) {
+		if(vfs::current().exists(target)) {
+			if(vfs::current().is_directory(target)) {
 				ui->set_error_message("Cannot paste \"" + target + "\" (Directory exists)");
 			} else {
 				ui->set_error_message("Cannot paste \"" + target + "\" (File exists)");
@@ -863,7 +1387,7 @@ void commands::paste(user_interface *ui) {
 		}
 
 		// more exists error
-		if(!boost::filesystem::exists(line)) {
+		if(!vfs::current().exists(line)) {
 			ui->set_error_message("Cannot paste \"" + line + "\" (No such file or directory)");
 			return;
 		}
@@ -874,40 +1398,48 @@ void commands::paste(user_interface *ui) {
 			return;
 		}
 
-		std::error_code error;
-		std::experimental::filesystem::copy(line, target, std::experimental::filesystem::copy_options::recursive, error);
+		std::string failed;
+		int error = vfs::current().copy_all(line, target, failed);
 
-		// permission error
-		if(error.value() == 13) {
-			ui->set_error_message("Cannot paste \"" + target + "\" (Permission denied)");
+		if(error != 0) {
+			ui->set_error_message("Cannot paste \"" + failed + "\" (" + strerror(error) + ")");
 			return;
 		}
 	}
 
-	ui->set_selected(std::vector<int>{ui->get_selected()[0]});
+	ui->clear_selection();
 }
 
-void commands::top(user_interface *ui) {
+// a count goes to that entry instead, like 50gg in vim
+void commands::top(int count, user_interface *ui) {
 	if(!ui->get_main_elements().empty()) {
-		set({"1"}, ui);
+		set({std::to_string(count != 0 ? count : 1)}, ui);
 	}
 }
 
-void commands::bottom(user_interface *ui) {
+void commands::bottom(int count, user_interface *ui) {
 	if(!ui->get_main_elements().empty()) {
-		set({std::to_string(ui->get_main_elements().size())}, ui);
+		set({std::to_string(count != 0 ? count : ui->get_main_elements().size())}, ui);
+	}
+}
+
+void commands::shell(std::vector<std::string> args, user_interface *ui) {
+	int error = ui->get_children().run(combine_vector(args));
+	if(error != 0) {
+		ui->set_error_message("Cannot run \"" + combine_vector(args) + "\" (" + strerror(error) + ")");
 	}
 }
 
-void commands::shell(std::vector<std::string> args) {
-	system(combine_vector(args).c_str());
+void commands::jobs(user_interface *ui) {
+	std::string description = ui->get_children().describe();
+	ui->set_message(description == "" ? "no jobs." : description);
 }
 
 // asdf sdaf asdf asdf sf 
 
 void commands::extract(std::vector<std::string> args, user_interface *ui) {
 	if(args.size() == 0) {
-		boost::filesystem::path selected_filename(ui->get_main_elements()[ui->get_selected()[0]]);
+		boost::filesystem::path selected_filename(ui->get_main_elements()[ui->get_cursor()]);
 
 		if(selected_filename.extension().string() == ".bz2"
 		|| selected_filename.extension().string() == ".gz"
@@ -924,12 +1456,12 @@ void commands::extract(std::vector<std::string> args, user_interface *ui) {
 
 			filename = find_and_replace(filename, "\"", "\\\"");
 
-			if(!boost::filesystem::exists(filename)) {
+			if(!vfs::current().exists(filename)) {
 				mkdir({filename}, ui);
 				system(std::string("tar -xf \"" + selected_filename.string() + "\" -C " + filename).c_str());
-				ui->set_selected(std::vector<int>{ui->get_selected()[0]});
+				ui->clear_selection();
 			} else {
-				if(boost::filesystem::is_directory(filename)) {
+				if(vfs::current().is_directory(filename)) {
 					ui->set_error_message("Cannot extract to \"" + filename + "\" (Directory exists)");
 				} else {
 					ui->set_error_message("Cannot extract to \"" + filename + "\" (File exists)");
@@ -943,9 +1475,9 @@ void commands::extract(std::vector<std::string> args, user_interface *ui) {
 }
 
 void commands::compress(std::vector<std::string> args, user_interface *ui) {
-	std::vector<int> selected = ui->get_selected();
+	std::vector<int> selected = ui->get_selection().indices();
 	std::string elements = "";
-	for(int i = 1; i < selected.size(); i++) {
+	for(int i = 0; i < selected.size(); i++) {
 		elements += ui->get_main_elements()[selected[i]] + " ";
 	}
 
@@ -961,7 +1493,7 @@ void commands::compress(std::vector<std::string> args, user_interface *ui) {
 		return;
 	}
 
-	if(!boost::filesystem::exists(filename)) {
+	if(!vfs::current().exists(filename)) {
 		if(boost::filesystem::path(filename).extension().string() == ".gz") {
 			filename = find_and_replace(filename, "\"", "\\\"");
 			system(std::string("tar -czf \"" + filename + "\" " + elements).c_str());
@@ -976,7 +1508,7 @@ void commands::compress(std::vector<std::string> args, user_interface *ui) {
 			return;
 		}
 	} else {
-		if(boost::filesystem::is_directory(filename)) {
+		if(vfs::current().is_directory(filename)) {
 			ui->set_error_message("Cannot compress \"" + filename + "\" (Directory exists)");
 		} else {
 			ui->set_error_message("Cannot compress \"" + filename + "\" (File exists)");
@@ -984,42 +1516,234 @@ void commands::compress(std::vector<std::string> args, user_interface *ui) {
 		return;
 	}
 
-	ui->set_selected(std::vector<int>{ui->get_selected()[0]});
+	ui->clear_selection();
 }
 
-void commands::process_command(std::string command, user_interface *ui) {
+void commands::toggle_stats(user_interface *ui) {
+	stats::overlay = !stats::overlay;
+}
+
+// dumps recorded timings to a file for chrome://tracing or perfetto
+void commands::trace(std::vector<std::string> args, user_interface *ui) {
+	std::string filename = combine_vector(args);
+
+	if(filename == "") {
+		filename = "/tmp/odyssey-trace.json";
+	}
+
+	if(stats::dump(filename)) {
+		ui->set_message("trace written to \"" + filename + "\"");
+	} else {
+		ui->set_error_message("Cannot write trace \"" + filename + "\" (Permission denied)");
+	}
+}
+
+// shows how well the listing cache does
+void commands::cache_stats(user_interface *ui) {
+	ui->set_message(ui->get_cache()->describe());
+}
+
+// opens a tab in the given directory or the current one
+void commands::tab_new(std::vector<std::string> args, user_interface *ui) {
+	std::string directory = combine_vector(args);
+
+	if(directory == "") {
+		directory = ui->get_current_path();
+	}
+
+	if(!vfs::current().exists(directory)) {
+		ui->set_error_message("Cannot open tab \"" + directory + "\" (No such file or directory)");
+		return;
+	}
+
+	if(!vfs::current().is_directory(directory)) {
+		ui->set_error_message("Cannot open tab \"" + directory + "\" (Not a directory)");
+		return;
+	}
+
+	ui->new_tab(resolved(directory));
+}
+
+void commands::tab(std::vector<std::string> args, user_interface *ui) {
+	std::string number = combine_vector(args);
+
+	if(number == "" || !is_digit(number)) {
+		ui->set_error_message("\"" + number + "\" cannot be converted to integer");
+		return;
+	}
+
+	if(!ui->switch_tab(std::stoi(number) - 1)) {
+		ui->set_error_message("\"" + number + "\" is not in bounds");
+	}
+}
+
+void commands::tab_next(user_interface *ui) {
+	ui->switch_tab((ui->get_current_tab() + 1) % ui->get_tab_count());
+}
+
+void commands::tab_previous(user_interface *ui) {
+	ui->switch_tab((ui->get_current_tab() + ui->get_tab_count() - 1) % ui->get_tab_count());
+}
+
+void commands::tab_close(user_interface *ui) {
+	if(!ui->close_tab()) {
+		ui->set_error_message("Cannot close tab (Last tab)");
+	}
+}
+
+// cd to the most frecent visited directory matching every argument
+void commands::jump(std::vector<std::string> args, user_interface *ui) {
+	std::string directory = ui->get_frecency().jump(args);
+
+	if(directory == "") {
+		ui->set_error_message("Cannot jump to \"" + combine_vector(args) + "\" (No match)");
+		return;
+	}
+
+	cd({directory}, ui);
+}
+
+// commands that take a count themselves, the others are run count times
+static bool takes_count(action command) {
+	switch(command) {
+		case DOWN : case UP : case TOP : case BOTTOM : case SELECT : case REPEAT :
+		case GET : case SET : case REMOVE : case YANK : case COPY : case OPEN :
+			return true;
+		default :
+			return false;
+	}
+}
+
+// commands on the selection, a count selects as many entries from the cursor on
+static bool on_selection(action command) {
+	return command == REMOVE || command == YANK || command == COPY || command == OPEN;
+}
+
+// commands that change something, the ones . repeats
+static bool repeatable(action command) {
+	switch(command) {
+		case MKDIR : case MOVE : case BMOVE : case EMOVE : case RENAME : case REMOVE :
+		case TOUCH : case SELECT : case SELECTALL : case INVERT : case UNSELECT :
+		case SELECTRANGE : case SELECTGLOB : case SELECTREGEX : case COPY : case COPYDIR :
+		case PASTE : case YANK : case SHELL : case EXTRACT : case COMPRESS :
+			return true;
+		default :
+			return false;
+	}
+}
+
+// runs the last command that changed something again, with a new count if one is given
+void commands::repeat(int count, user_interface *ui) {
+	std::string command = ui->get_last_command();
+	if(command == "") {
+		ui->set_error_message("Cannot repeat (No command yet)");
+		return;
+	}
+
+	process_command(command, ui, count != 0 ? count : ui->get_last_count());
+}
+
+// commands after which the listings shown are still current
+static bool keeps_listings(action command) {
+	switch(command) {
+		case DOWN : case UP : case SET : case TOP : case BOTTOM : case SELECT : case SELECTALL :
+		case INVERT : case UNSELECT : case SELECTRANGE : case SELECTGLOB : case SELECTREGEX :
+		case YANK : case REGISTERS : case JOBS : case STATS : case TRACE : case CACHESTATS :
+			return true;
+		default :
+			return false;
+	}
+}
+
+// count is what was typed before the key, 0 without one. however large,
+// the command is applied to the state first and listings are loaded once
+void commands::process_command(std::string command, user_interface *ui, int count) {
+	run_command(command, ui, count);
+	load_listings(ui);
+}
+
+// runs a command without loading the listings after it, true if they
+// may have to be. a batch of commands only loads them where needed
+bool commands::run_command(std::string command, user_interface *ui, int count) {
 	std::vector<std::string> args = ui->split_into_args(command);
 	std::vector<std::string> argsp = std::vector<std::string>(args.begin() + 1, args.end());
 	bool executed = false;
+	bool stale = false;
+
+	scoped_timer timer("command " + args[0]);
 
 	for(int i = 0; i < command_map.size(); i++) {
 		if(command_map[i].name == args[0]) {
-			switch(command_map[i].command) {
-				case QUIT : quit(argsp); break;
-				case DOWN : down(ui); break;
-				case UP : up(ui); break;
-				case LOAD : load(argsp, ui); break;
-				case GET : mvprintw(LINES - 1, 0, ":"); process_command(get(argsp, 1, false, ui), ui); break;
-				case CD : cd(argsp, ui); break;
-				case SET : set(argsp, ui); break;
-				case HIDDEN : hidden(ui); break;
-				case MKDIR : mkdir(argsp, ui); break;
-				case OPEN : open(argsp, ui); break;
-				case MOVE : move_file(argsp, ui); break;
-				case BMOVE : begin_move(argsp, ui); break;
-				case EMOVE : end_move(argsp, ui); break;
-				case REMOVE : remove(argsp, ui); break;
-				case TOUCH : touch(argsp, ui); break;
-				case SELECT : select(argsp, ui); break;
-				case COPY : copy(argsp, ui); break;
-				case COPYDIR : copy_directory(ui); break;
-				case PASTE : paste(ui); break;
-				case TOP : top(ui); break;
-				case BOTTOM : bottom(ui); break;
-				case SHELL : shell(argsp); break;
-				case RENAME : rename(argsp, ui); break;
-				case EXTRACT : extract(argsp, ui); break;
-				case COMPRESS : compress(argsp, ui); break;
+			action type = command_map[i].command;
+
+			if(count > 1 && on_selection(type) && argsp.empty() && ui->get_selection().empty()) {
+				ui->get_selection().set_range(ui->get_cursor(), ui->get_cursor() + count - 1);
+			}
+
+			if(repeatable(type)) {
+				ui->set_last_command(command, count);
+			}
+
+			stale = stale || !keeps_listings(type);
+
+			int times = takes_count(type) ? 1 : std::max(count, 1);
+			for(int n = 0; n < times; n++) {
+				switch(type) {
+					case QUIT : quit(argsp); break;
+					case DOWN : down(count, ui); break;
+					case UP : up(count, ui); break;
+					case LOAD : ui->invalidate(); load(argsp, ui); break;
+					case GET : mvprintw(LINES - 1, 0, ":"); process_command(get(argsp, 1, false, ui), ui); break;
+					case CD : cd(argsp, ui); break;
+					case SET : set(argsp, ui); break;
+					case HIDDEN : hidden(ui); break;
+					case PARENT : parent(ui); break;
+					case LONGLISTING : long_listing(ui); break;
+					case GITSTATUS : git_status(ui); break;
+					case TREE : tree(ui); break;
+					case EXPAND : expand(ui); break;
+					case DUPES : dupes(ui); break;
+					case LINK : link(ui); break;
+					case COMPARE : compare(argsp, ui); break;
+					case SYNC : sync(ui); break;
+					case MKDIR : mkdir(argsp, ui); break;
+					case OPEN : open(argsp, ui); break;
+					case MOVE : move_file(argsp, ui); break;
+					case BMOVE : begin_move(argsp, ui); break;
+					case EMOVE : end_move(argsp, ui); break;
+					case REMOVE : remove(argsp, ui); break;
+					case TOUCH : touch(argsp, ui); break;
+					case SELECT : select(count, ui); break;
+					case SELECTALL : select_all(ui); break;
+					case INVERT : invert(ui); break;
+					case UNSELECT : unselect(ui); break;
+					case SELECTRANGE : select_range(argsp, ui); break;
+					case SELECTGLOB : select_pattern(argsp, false, ui); break;
+					case SELECTREGEX : select_pattern(argsp, true, ui); break;
+					case COPY : copy(argsp, ui); break;
+					case COPYDIR : copy_directory(ui); break;
+					case PASTE : paste(argsp, ui); break;
+					case YANK : yank(argsp, ui); break;
+					case REGISTERS : show_registers(ui); break;
+					case JOBS : jobs(ui); break;
+					case PLAYLIST : playlist(ui); break;
+					case REPEAT : repeat(count, ui); break;
+					case TOP : top(count, ui); break;
+					case BOTTOM : bottom(count, ui); break;
+					case SHELL : shell(argsp, ui); break;
+					case RENAME : rename(argsp, ui); break;
+					case EXTRACT : extract(argsp, ui); break;
+					case COMPRESS : compress(argsp, ui); break;
+					case STATS : toggle_stats(ui); break;
+					case TRACE : trace(argsp, ui); break;
+					case CACHESTATS : cache_stats(ui); break;
+					case TABNEW : tab_new(argsp, ui); break;
+					case TAB : tab(argsp, ui); break;
+					case TABNEXT : tab_next(ui); break;
+					case TABPREV : tab_previous(ui); break;
+					case TABCLOSE : tab_close(ui); break;
+					case JUMP : jump(argsp, ui); break;
+				}
 			}
 			executed = true;
 		}
@@ -1029,7 +1753,16 @@ void commands::process_command(std::string command, user_interface *ui) {
 		}
 	}
 
+	return stale;
+}
+
+void commands::load_listings(user_interface *ui) {
+	// what the command changed on disk is patched in, the loads below
+	// then only read directories that are new or cannot be watched
+	ui->get_cache()->apply(true);
+
 	load({"main"}, ui);
 	ui->bound_selected();
+	load({"parent"}, ui);
 	load({"preview"}, ui);
 }
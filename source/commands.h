@@ -14,28 +14,42 @@ class commands {
 
 		/* public helper functions */
 
-		static std::string file_last_mod_time(std::string directory);
+		static std::string file_last_mod_time(time_t time);
 		static std::string format_file_size(double file_size, int precision);
 		static double file_sizes(std::string directory);
 		static double file_size(std::string directory);
 		static int directory_items(std::string directory);
-		static std::string file_permissions(std::string directory);
-		static std::string file_owner(std::string directory);
+		static std::string file_permissions(mode_t mode);
+		static std::string file_owner(uid_t uid, gid_t gid);
 		static double free_space(std::string directory);
 		static std::string find_and_replace(std::string str, std::string search, std::string replace);
+		static void read_directory(std::string directory, int limit, listing &elements, bool count_items = true);
+		static void add_entry(std::string directory, std::string_view filename, const struct statx &info,
+				listing &elements, bool count_items = true);
 
 		/* main functions */
 
 		static void quit(std::vector<std::string> args);
-		static void up(user_interface *ui);
-		static void down(user_interface *ui);
+		static void up(int count, user_interface *ui);
+		static void down(int count, user_interface *ui);
 		static void set(std::vector<std::string> args, user_interface *ui);
 		static void load(std::vector<std::string> args, user_interface *ui);
 		static std::string get(std::vector<std::string> args, int drawx, bool locked, user_interface *ui);
 		static void hidden(user_interface *ui);
+		static void parent(user_interface *ui);
+		static void long_listing(user_interface *ui);
+		static void git_status(user_interface *ui);
+		static void tree(user_interface *ui);
+		static void expand(user_interface *ui);
+		static void dupes(user_interface *ui);
+		static void link(user_interface *ui);
+		static void compare(std::vector<std::string> args, user_interface *ui);
+		static void sync(user_interface *ui);
 		static void cd(std::vector<std::string> args, user_interface *ui);
 		static void mkdir(std::vector<std::string> args, user_interface *ui);
 		static void open(std::vector<std::string> args, user_interface *ui);
+		static void open_files(std::vector<std::string> files, int index, user_interface *ui);
+		static void playlist(user_interface *ui);
 		static void move_file(std::vector<std::string> args, user_interface *ui);
 		static void begin_move(std::vector<std::string> args, user_interface *ui);
 		static void end_move(std::vector<std::string> args, user_interface *ui);
@@ -43,17 +57,37 @@ class commands {
 		static void remove(std::vector<std::string> args, user_interface *ui);
 		static void remove_all(std::vector<std::string> args, user_interface *ui);
 		static void touch(std::vector<std::string> args, user_interface *ui);
-		static void select(std::vector<std::string> args, user_interface *ui);
+		static void select(int count, user_interface *ui);
+		static void select_all(user_interface *ui);
+		static void invert(user_interface *ui);
+		static void unselect(user_interface *ui);
+		static void select_range(std::vector<std::string> args, user_interface *ui);
+		static void select_pattern(std::vector<std::string> args, bool regex, user_interface *ui);
 		static void copy(std::vector<std::string> args, user_interface *ui);
 		static void copy_all(std::vector<std::string> args, user_interface *ui);
 		static void copy_directory(user_interface *ui);
-		static void paste(user_interface *ui);
-		static void top(user_interface *ui);
-		static void bottom(user_interface *ui);
-		static void shell(std::vector<std::string> args);
+		static void yank(std::vector<std::string> args, user_interface *ui);
+		static void show_registers(user_interface *ui);
+		static void paste(std::vector<std::string> args, user_interface *ui);
+		static void top(int count, user_interface *ui);
+		static void bottom(int count, user_interface *ui);
+		static void shell(std::vector<std::string> args, user_interface *ui);
+		static void jobs(user_interface *ui);
 		static void extract(std::vector<std::string> args, user_interface *ui);
 		static void compress(std::vector<std::string> args, user_interface *ui);
-		static void process_command(std::string command, user_interface *ui);
+		static void toggle_stats(user_interface *ui);
+		static void trace(std::vector<std::string> args, user_interface *ui);
+		static void cache_stats(user_interface *ui);
+		static void tab_new(std::vector<std::string> args, user_interface *ui);
+		static void tab(std::vector<std::string> args, user_interface *ui);
+		static void tab_next(user_interface *ui);
+		static void tab_previous(user_interface *ui);
+		static void tab_close(user_interface *ui);
+		static void jump(std::vector<std::string> args, user_interface *ui);
+		static void repeat(int count, user_interface *ui);
+		static void process_command(std::string command, user_interface *ui, int count = 0);
+		static bool run_command(std::string command, user_interface *ui, int count = 0);
+		static void load_listings(user_interface *ui);
 };
 
 # endif
@@ -0,0 +1,406 @@
+# ifndef COMPARE_H
+# define COMPARE_H
+
+enum compare_state {
+	COMPARE_LEFT,
+	COMPARE_RIGHT,
+	COMPARE_DIFFERS,
+	COMPARE_UNREADABLE,
+};
+
+// what sets a path of one tree apart from the other, same paths are only counted
+struct compare_entry {
+	std::string path;
+	compare_state state;
+	ino_t inode;
+};
+
+// compares two trees directory by directory on every core. files of the
+// same size and modification time count as the same, only files of the
+// same size but another time are read, and only up to the first byte
+// that differs. differences are handed over while the walk goes on and
+// shown as the main listing of the left directory, the preview shows the
+// right side of the row under the cursor
+class directory_compare {
+	private:
+
+		struct side {
+			std::vector<std::string> names;
+			std::vector<struct statx> infos;
+			int error = 0;
+		};
+
+		// state shared by the walking threads and the ui
+		struct walk {
+			std::mutex mutex;
+			std::condition_variable wake;
+			std::deque<std::string> pending;
+			int busy = 0;
+			bool done = false;
+			std::atomic<bool> cancelled;
+
+			std::vector<compare_entry> found;
+			unsigned long same = 0;
+			unsigned long last_flush = 0;
+
+			walk() : cancelled(false) {}
+		};
+
+		std::shared_ptr<walk> current;
+		int fd = -1;
+
+		std::string left;
+		std::string right;
+		std::vector<compare_entry> entries;
+		std::unordered_map<std::string, compare_state> states;
+		std::shared_ptr<const listing> shown;
+		unsigned long same = 0;
+		bool running = false;
+
+		static std::string join(const std::string &root, const std::string &relative) {
+			return relative.empty() ? root : (root == "/" ? "" : root) + "/" + relative;
+		}
+
+		static void read_side(const std::string &path, side &result) {
+			std::unique_ptr<vfs_directory> directory = vfs::current().open_directory(path);
+			result.error = directory->error();
+			if(result.error != 0) {
+				return;
+			}
+
+			std::string_view name;
+			unsigned char type;
+			ino_t inode;
+			while(directory->next(name, type, inode)) {
+				if(show_hidden || name[0] != '.') {
+					result.names.emplace_back(name);
+				}
+			}
+			directory->done_reading();
+			std::sort(result.names.begin(), result.names.end());
+
+			std::vector<const char*> batch;
+			std::vector<struct statx> infos;
+			std::vector<int> errors;
+			for(std::size_t first = 0; first < result.names.size(); first += stat_batch_size) {
+				std::size_t count = std::min<std::size_t>(stat_batch_size, result.names.size() - first);
+				batch.clear();
+				for(std::size_t i = first; i < first + count; i++) {
+					batch.push_back(result.names[i].c_str());
+				}
+				directory->stat(batch, AT_SYMLINK_NOFOLLOW | AT_STATX_DONT_SYNC, STATX_TYPE | STATX_SIZE | STATX_MTIME | STATX_INO,
+					infos, errors);
+
+				// a name gone since it was read has no type, it shows as unreadable
+				for(std::size_t i = 0; i < count; i++) {
+					if(errors[i] != 0) {
+						infos[i].stx_mode = 0;
+					}
+				}
+				result.infos.insert(result.infos.end(), infos.begin(), infos.begin() + count);
+			}
+		}
+
+		// reads both files until they differ, false also if one cannot be read
+		static bool same_content(const std::string &first, const std::string &second, unsigned long size,
+				std::vector<char> &buffer) {
+
+			std::unique_ptr<std::istream> a = vfs::current().open_file(first);
+			std::unique_ptr<std::istream> b = vfs::current().open_file(second);
+			if(a == nullptr || b == nullptr) {
+				return false;
+			}
+
+			std::size_t half = buffer.size() / 2;
+			for(unsigned long left = size; left != 0;) {
+				unsigned long length = std::min<unsigned long>(left, half);
+				a->read(buffer.data(), length);
+				b->read(buffer.data() + half, length);
+				if(static_cast<unsigned long>(a->gcount()) != length || static_cast<unsigned long>(b->gcount()) != length) {
+					return false;
+				}
+				stats::bytes_read += 2 * length;
+
+				if(memcmp(buffer.data(), buffer.data() + half, length) != 0) {
+					return false;
+				}
+				left -= length;
+			}
+			return true;
+		}
+
+		static bool same_file(const struct statx &a, const struct statx &b) {
+			return a.stx_size == b.stx_size && a.stx_mtime.tv_sec == b.stx_mtime.tv_sec
+				&& a.stx_mtime.tv_nsec == b.stx_mtime.tv_nsec;
+		}
+
+		// copies of symlinks get their own times, where they point is what counts
+		static bool same_link(const std::string &first, const std::string &second) {
+			std::string a, b;
+			return vfs::current().read_link(first, a) == 0 && vfs::current().read_link(second, b) == 0 && a == b;
+		}
+
+		// one directory of both trees, directories in both are walked next
+		static void compare_directory(const std::string &left, const std::string &right, const std::string &relative,
+				std::vector<compare_entry> &found, std::vector<std::string> &directories, unsigned long &same,
+				std::vector<char> &buffer) {
+
+			side a, b;
+			read_side(join(left, relative), a);
+			read_side(join(right, relative), b);
+
+			std::string prefix = relative.empty() ? "" : relative + "/";
+			if(a.error != 0 || b.error != 0) {
+				found.push_back({ prefix, COMPARE_UNREADABLE, 0 });
+				return;
+			}
+
+			auto add = [&](const std::string &name, const struct statx &info, compare_state state) {
+				std::string path = prefix + name + (S_ISDIR(info.stx_mode) ? "/" : "");
+				found.push_back({ path, state, info.stx_ino });
+			};
+
+			std::size_t i = 0, j = 0;
+			while(i < a.names.size() || j < b.names.size()) {
+				int order = i == a.names.size() ? 1 : j == b.names.size() ? -1 : a.names[i].compare(b.names[j]);
+
+				if(order < 0) {
+					add(a.names[i], a.infos[i], COMPARE_LEFT);
+					i++;
+					continue;
+				} else if(order > 0) {
+					add(b.names[j], b.infos[j], COMPARE_RIGHT);
+					j++;
+					continue;
+				}
+
+				const struct statx &x = a.infos[i], &y = b.infos[j];
+				mode_t type = x.stx_mode & S_IFMT;
+
+				if(x.stx_mode == 0 || y.stx_mode == 0) {
+					add(a.names[i], x, COMPARE_UNREADABLE);
+				} else if(type != (y.stx_mode & S_IFMT)) {
+					add(a.names[i], x, COMPARE_DIFFERS);
+				} else if(S_ISDIR(x.stx_mode)) {
+					directories.push_back(prefix + a.names[i]);
+				} else if(same_file(x, y) || (x.stx_size == y.stx_size && S_ISREG(x.stx_mode)
+				&& same_content(join(left, prefix + a.names[i]), join(right, prefix + b.names[j]), x.stx_size, buffer))
+				|| (x.stx_size == y.stx_size && S_ISLNK(x.stx_mode)
+				&& same_link(join(left, prefix + a.names[i]), join(right, prefix + b.names[j])))) {
+					same++;
+				} else {
+					add(a.names[i], x, COMPARE_DIFFERS);
+				}
+				i++;
+				j++;
+			}
+		}
+
+		static void work(std::shared_ptr<walk> state, std::string left, std::string right, int event) {
+			std::vector<char> buffer(compare_buffer_size);
+			std::unique_lock<std::mutex> lock(state->mutex);
+
+			while(true) {
+				state->wake.wait(lock, [&state]() {
+					return !state->pending.empty() || state->busy == 0 || state->cancelled;
+				});
+				if(state->pending.empty() || state->cancelled) {
+					state->wake.notify_all();
+					return;
+				}
+
+				std::string relative = std::move(state->pending.front());
+				state->pending.pop_front();
+				state->busy++;
+				lock.unlock();
+
+				std::vector<compare_entry> found;
+				std::vector<std::string> directories;
+				unsigned long same = 0;
+				compare_directory(left, right, relative, found, directories, same, buffer);
+
+				lock.lock();
+				state->busy--;
+				state->same += same;
+				state->pending.insert(state->pending.end(), directories.begin(), directories.end());
+				state->found.insert(state->found.end(), std::make_move_iterator(found.begin()),
+					std::make_move_iterator(found.end()));
+				state->wake.notify_all();
+
+				// rows come in batches, the listing is not rebuilt for each
+				unsigned long now = stats::now();
+				if(!state->found.empty() && now - state->last_flush >= compare_flush_interval * 1000UL) {
+					state->last_flush = now;
+					unsigned long long one = 1;
+					if(::write(event, &one, sizeof(one)) < 0) {
+						return;
+					}
+				}
+			}
+		}
+
+		void show() {
+			std::shared_ptr<listing> elements = std::make_shared<listing>();
+			elements->hidden = show_hidden;
+
+			static const char *labels[] = { "left only", "right only", "differs", "unreadable" };
+			for(const auto &entry : entries) {
+				elements->add(entry.path.empty() ? "./" : entry.path, labels[entry.state], entry.inode);
+			}
+			shown = elements;
+		}
+
+	public:
+
+		directory_compare() {
+			fd = eventfd(0, EFD_NONBLOCK | EFD_CLOEXEC);
+		}
+
+		~directory_compare() {
+			close_view();
+			if(fd != -1) {
+				close(fd);
+			}
+		}
+
+		int get_fd() const {
+			return fd;
+		}
+
+		// compares two directories off the ui thread, one before stops
+		void start(const std::string &left_, const std::string &right_) {
+			close_view();
+
+			left = left_;
+			right = right_;
+			running = true;
+			current = std::make_shared<walk>();
+			current->pending.push_back("");
+			show();
+
+			std::shared_ptr<walk> state = current;
+			int event = fd;
+			int cores = compare_threads != 0 ? compare_threads : std::max(1u, std::thread::hardware_concurrency());
+
+			std::thread([state, left_, right_, event, cores]() {
+				std::vector<std::thread> threads;
+				for(int i = 0; i < cores; i++) {
+					threads.emplace_back(work, state, left_, right_, event);
+				}
+				for(auto &thread : threads) {
+					thread.join();
+				}
+
+				{
+					std::lock_guard<std::mutex> lock(state->mutex);
+					state->done = true;
+				}
+				unsigned long long one = 1;
+				if(::write(event, &one, sizeof(one)) < 0) {
+					return;
+				}
+			}).detach();
+		}
+
+		bool is_running() const {
+			return running;
+		}
+
+		// takes over the rows found since, true if there are any or the
+		// walk is over
+		bool collect() {
+			unsigned long long count;
+			stats::syscalls++;
+			if(fd == -1 || ::read(fd, &count, sizeof(count)) != sizeof(count) || current == nullptr) {
+				return false;
+			}
+
+			std::vector<compare_entry> found;
+			bool done;
+			{
+				std::lock_guard<std::mutex> lock(current->mutex);
+				found.swap(current->found);
+				same = current->same;
+				done = current->done;
+			}
+			if(found.empty() && !done) {
+				return false;
+			}
+
+			for(auto &entry : found) {
+				states[entry.path] = entry.state;
+				entries.push_back(std::move(entry));
+			}
+			std::sort(entries.begin(), entries.end(), [](const compare_entry &a, const compare_entry &b) {
+				return a.path < b.path;
+			});
+			show();
+
+			if(done) {
+				running = false;
+				current = nullptr;
+			}
+			return true;
+		}
+
+		std::string describe() const {
+			unsigned long counts[4] = {};
+			for(const auto &entry : entries) {
+				counts[entry.state]++;
+			}
+
+			return std::string(running ? "comparing " : "compared ") + left + " with " + right + ": "
+				+ std::to_string(counts[COMPARE_LEFT]) + " left only, " + std::to_string(counts[COMPARE_RIGHT]) + " right only, "
+				+ std::to_string(counts[COMPARE_DIFFERS]) + " differ, " + std::to_string(same) + " same"
+				+ (counts[COMPARE_UNREADABLE] != 0 ? ", " + std::to_string(counts[COMPARE_UNREADABLE]) + " unreadable" : "");
+		}
+
+		// the differences as a listing if they belong to directory, nullptr otherwise
+		std::shared_ptr<const listing> view(const std::string &directory) const {
+			return shown != nullptr && directory == left ? shown : nullptr;
+		}
+
+		// stops a walk that is still going and forgets the rows
+		void close_view() {
+			if(current != nullptr) {
+				current->cancelled = true;
+				current->wake.notify_all();
+				current = nullptr;
+			}
+			running = false;
+			left.clear();
+			right.clear();
+			entries.clear();
+			states.clear();
+			shown = nullptr;
+			same = 0;
+		}
+
+		std::string left_path(const std::string &name) const {
+			return join(left, name.back() == '/' ? name.substr(0, name.length() - 1) : name);
+		}
+
+		std::string right_path(const std::string &name) const {
+			return join(right, name.back() == '/' ? name.substr(0, name.length() - 1) : name);
+		}
+
+		// what a shown row is, COMPARE_UNREADABLE for one that is not
+		compare_state state(const std::string &name) const {
+			auto found = states.find(name);
+			return found != states.end() ? found->second : COMPARE_UNREADABLE;
+		}
+
+		// rows that were synced
+		void forget(const std::vector<std::string> &names) {
+			std::unordered_set<std::string> gone(names.begin(), names.end());
+			entries.erase(std::remove_if(entries.begin(), entries.end(), [&gone](const compare_entry &entry) {
+				return gone.count(entry.path) != 0;
+			}), entries.end());
+			for(const auto &name : names) {
+				states.erase(name);
+			}
+			show();
+		}
+};
+
+# endif
@@ -10,9 +10,120 @@ static constexpr int selected_space_size = 2;
 /* specify the directory on launch */
 static const std::string starting_directory = "/";
 
+/* amount of trace events kept for the trace command */
+static constexpr int max_trace_events = 100000;
+
 /* show hidden files or not */
 static bool show_hidden = false;
 
+/* show the parent directory column or not */
+static bool show_parent = false;
+
+/* show the main pane as a tree of expandable directories or not */
+static bool show_tree = false;
+
+/* show permissions, owner and time in front of every file or not */
+static bool show_long_listing = false;
+
+/* color files by their git status or not */
+static bool show_git_status = true;
+
+/* milliseconds between looks at the git index, and between scans of a repository while files change */
+static constexpr int git_check_interval = 2000;
+
+/* threads hashing files while looking for duplicates, 0 for one per core */
+static constexpr int dupes_threads = 0;
+
+/* bytes hashed at both ends of a file before the whole file is */
+static constexpr int dupes_sample_size = 4096;
+
+/* bytes of a file read at once while hashing it */
+static constexpr int dupes_buffer_size = 1 << 20;
+
+/* threads walking both trees of a comparison, 0 for one per core */
+static constexpr int compare_threads = 0;
+
+/* bytes of each of two files read at once while comparing them */
+static constexpr int compare_buffer_size = 1 << 20;
+
+/* milliseconds between batches of differences shown while a comparison runs */
+static constexpr int compare_flush_interval = 100;
+
+/* width of the owner column of the long listing */
+static constexpr int long_owner_width = 16;
+
+/* amount of formatted modification minutes kept */
+static constexpr int max_cached_minutes = 4096;
+
+/* milliseconds a local filesystem call may take before its mount counts as hung */
+static constexpr int local_deadline = 500;
+
+/* same for mounts of the remote filesystems below */
+static constexpr int remote_deadline = 3000;
+
+/* filesystem types that are slow, subdirectories are not counted on them */
+static const std::vector<std::string> remote_filesystems = {
+	"nfs", "nfs4", "cifs", "smb3", "smbfs", "9p", "afs", "ceph", "glusterfs",
+	"lustre", "fuse.sshfs", "fuse.rclone", "fuse.s3fs", "fuse.gcsfuse", "davfs",
+};
+
+/* microseconds file changes are gathered before the listing is patched */
+static constexpr int watch_coalesce_time = 50000;
+
+/* milliseconds the idle loop sleeps at most without input */
+static constexpr int idle_timeout = 1000;
+
+/* bytes of directory entries read at once */
+static constexpr int directory_buffer_size = 1 << 20;
+
+/* amount of names whose metadata is asked for at once */
+static constexpr int stat_batch_size = 4096;
+
+/* amount of metadata requests in flight through io_uring */
+static constexpr int stat_ring_depth = 256;
+
+/* amount of threads asking for metadata without io_uring */
+static constexpr int stat_threads = 16;
+
+/* amount of names of a batch stat'ed directly to see if they are cached */
+static constexpr int stat_probe_size = 32;
+
+/* microseconds per stat under which a batch counts as cached */
+static constexpr int stat_cached_time = 20;
+
+/* where yanks into the unnamed register also go: 0 nowhere, 1 the terminal clipboard (osc 52), 2 X through xclip */
+static constexpr int clipboard_export = 1;
+
+/* bytes of paths at most sent to the terminal clipboard, terminals drop longer ones */
+static constexpr std::size_t max_osc52_size = 100000;
+
+/* frames drawn a second at most, keys coming in faster are handled together */
+static constexpr int max_frame_rate = 60;
+
+/* connections waiting on the control socket at most */
+static constexpr int control_backlog = 16;
+
+/* bytes a control request line may have */
+static constexpr std::size_t control_line_limit = 1 << 20;
+
+/* largest count that can be typed before a key */
+static constexpr int max_count = 1000000;
+
+/* relative widths of parent, main and preview columns */
+static const std::vector<int> column_ratios = { 1, 2, 2 };
+
+/* amount of directories whose last selected file is remembered */
+static constexpr int max_file_history = 4096;
+
+/* summed rank at which visited directories start to fade out */
+static constexpr double max_frecency_rank = 10000;
+
+/* amount of directory listings kept in memory, each one is watched */
+static constexpr int max_cached_listings = 1024;
+
+/* bytes of directory listings kept in memory */
+static constexpr std::size_t listing_cache_budget = 256 << 20;
+
 /* map a name to a command */
 static const std::vector<command> command_map = {
 	{ "q",          QUIT },
@@ -23,6 +134,15 @@ static const std::vector<command> command_map = {
 	{ "get",        GET },
 	{ "cd",         CD },
 	{ "hidden",     HIDDEN },
+	{ "parent",     PARENT },
+	{ "long",       LONGLISTING },
+	{ "git",        GITSTATUS },
+	{ "tree",       TREE },
+	{ "expand",     EXPAND },
+	{ "dupes",      DUPES },
+	{ "link",       LINK },
+	{ "compare",    COMPARE },
+	{ "sync",       SYNC },
 	{ "mkdir",      MKDIR },
 	{ "open",       OPEN },
 	{ "mv",         MOVE },
@@ -32,14 +152,34 @@ static const std::vector<command> command_map = {
 	{ "rm",         REMOVE },
 	{ "touch",      TOUCH },
 	{ "select",     SELECT },
+	{ "selectall",  SELECTALL },
+	{ "invert",     INVERT },
+	{ "unselect",   UNSELECT },
+	{ "selectrange", SELECTRANGE },
+	{ "selectglob", SELECTGLOB },
+	{ "selectregex", SELECTREGEX },
 	{ "cp",         COPY },
 	{ "cpdir",      COPYDIR },
 	{ "paste",      PASTE },
+	{ "yank",       YANK },
+	{ "registers",  REGISTERS },
+	{ "jobs",       JOBS },
+	{ "playlist",   PLAYLIST },
+	{ "repeat",     REPEAT },
 	{ "top",        TOP },
 	{ "bottom",     BOTTOM },
 	{ "sh",         SHELL },
 	{ "extract",    EXTRACT },
 	{ "compress",   COMPRESS },
+	{ "stats",      STATS },
+	{ "trace",      TRACE },
+	{ "cachestats", CACHESTATS },
+	{ "tabnew",     TABNEW },
+	{ "tab",        TAB },
+	{ "tabnext",    TABNEXT },
+	{ "tabprev",    TABPREV },
+	{ "tabclose",   TABCLOSE },
+	{ "z",          JUMP },
 };
 
 /* map a key to a command */
@@ -50,7 +190,7 @@ std::vector<event> event_map = {
 	{ ':',   -1,      "get -1" },
 	{ 'l',   -1,      "open" },
 	{ 'h',   -1,      "cd .." },
-	{ '.',   -1,      "hidden" },
+	{ '.',   -1,      "repeat" },
 	{ 'd',   -1,      "get 6 mkdir " },
 	{ 'm',   -1,      "mv"},
 	{ 'A',   -1,      "emv" },
@@ -58,13 +198,36 @@ std::vector<event> event_map = {
 	{ 'r',   -1,      "rn" },
 	{ 'd',   -1,      "rm" },
 	{ ' ',   -1,      "select" },
+	{ 'v',   -1,      "invert" },
+	{ 'V',   -1,      "selectall" },
+	{ 'u',   -1,      "unselect" },
 	{ 'c',   -1,      "cp" },
 	{ 'D',   -1,      "cpdir" },
 	{ 'p',   -1,      "paste" },
+	{ 'y',   'y',     "yank" },
 	{ 't',   -1,      "get 6 touch " },
+	{ 'z',   -1,      "get 2 z " },
 	{ 'G',   -1,      "bottom" },
 	{ 'g',   'g',     "top" },
 	{ 'g',   'h',     "cd /home" },
+	{ 'g',   'p',     "parent" },
+	{ 'g',   'l',     "long" },
+	{ 'g',   's',     "git" },
+	{ 'g',   'r',     "tree" },
+	{ '\t',  -1,      "expand" },
+	{ 'g',   'd',     "dupes" },
+	{ 'g',   'c',     "get 8 compare " },
+	{ 'g',   '.',     "hidden" },
+	{ 'g',   'o',     "playlist" },
+	{ 'g',   't',     "tabnext" },
+	{ 'g',   'T',     "tabprev" },
+};
+
+/* colors of files git status would list, the others keep the color of their type */
+static const std::vector<std::pair<char, int>> git_colors = {
+	{ 'M',  RED },
+	{ '?',  MAGENTA },
+	{ 'U',  RED|BRIGHT },
 };
 
 /* map file type to color */
@@ -149,56 +312,64 @@ static const std::vector<colors> colors_map = {
 	{ "",          WHITE },
 };
 
-static const std::vector<open> open_map = {
+/* opens files of extensions not in the map below, in the terminal */
+static const std::string default_opener = "vim {F}";
+
+/* map file extension to the program opening it. {f} is one file, a
+ * command with {F} is given every selected file at once, {i} and {n}
+ * are the position of the file under the cursor counted from 0 and 1.
+ * programs run beside odyssey with their output dropped, unless marked
+ * to take over the terminal like { ".txt", "less {F}", true } */
+static const std::vector<struct open> open_map = {
 	/* images */
-	{ ".jpg",       "sxiv {f} > /dev/null 2>&1" },
-	{ ".jpeg"       "sxiv {f} > /dev/null 2>&1" },
-	{ ".png",       "sxiv {f} > /dev/null 2>&1" },
-	{ ".gif",       "sxiv {f} > /dev/null 2>&1" },
-	{ ".tiff",      "sxiv {f} > /dev/null 2>&1" },
-	{ ".tif",       "sxiv {f} > /dev/null 2>&1" },
-	{ ".raw",       "sxiv {f} > /dev/null 2>&1" },
-	{ ".bmp",       "sxiv {f} > /dev/null 2>&1" },
+	{ ".jpg",       "sxiv -n {n} {F}" },
+	{ ".jpeg",      "sxiv -n {n} {F}" },
+	{ ".png",       "sxiv -n {n} {F}" },
+	{ ".gif",       "sxiv -n {n} {F}" },
+	{ ".tiff",      "sxiv -n {n} {F}" },
+	{ ".tif",       "sxiv -n {n} {F}" },
+	{ ".raw",       "sxiv -n {n} {F}" },
+	{ ".bmp",       "sxiv -n {n} {F}" },
 
 	/* vectors */
-	{ ".svg",       "sxiv {f} > /dev/null 2>&1" },
-	{ ".eps",       "sxiv {f} > /dev/null 2>&1" },
-	{ ".ai",        "sxiv {f} > /dev/null 2>&1" },
+	{ ".svg",       "sxiv -n {n} {F}" },
+	{ ".eps",       "sxiv -n {n} {F}" },
+	{ ".ai",        "sxiv -n {n} {F}" },
 	
 	/* videos */
-	{ ".mkv",       "mpv {f} > /dev/null 2>&1" },
-	{ ".flv",       "mpv {f} > /dev/null 2>&1" },
-	{ ".ogv",       "mpv {f} > /dev/null 2>&1" },
-	{ ".ogg",       "mpv {f} > /dev/null 2>&1" },
-	{ ".gif",       "mpv {f} > /dev/null 2>&1" },
-	{ ".avi",       "mpv {f} > /dev/null 2>&1" },
-	{ ".ts",        "mpv {f} > /dev/null 2>&1" },
-	{ ".mts",       "mpv {f} > /dev/null 2>&1" },
-	{ ".mov",       "mpv {f} > /dev/null 2>&1" },
-	{ ".wmv",       "mpv {f} > /dev/null 2>&1" },
-	{ ".mov",       "mpv {f} > /dev/null 2>&1" },
-	{ ".amv",       "mpv {f} > /dev/null 2>&1" },
-	{ ".mp4",       "mpv {f} > /dev/null 2>&1" },
-	{ ".m4p",       "mpv {f} > /dev/null 2>&1" },
-	{ ".m4v",       "mpv {f} > /dev/null 2>&1" },
-	{ ".mpg",       "mpv {f} > /dev/null 2>&1" },
-	{ ".mpeg",      "mpv {f} > /dev/null 2>&1" },
-	{ ".mpv",       "mpv {f} > /dev/null 2>&1" },
+	{ ".mkv",       "mpv --playlist-start={i} {F}" },
+	{ ".flv",       "mpv --playlist-start={i} {F}" },
+	{ ".ogv",       "mpv --playlist-start={i} {F}" },
+	{ ".ogg",       "mpv --playlist-start={i} {F}" },
+	{ ".gif",       "mpv --playlist-start={i} {F}" },
+	{ ".avi",       "mpv --playlist-start={i} {F}" },
+	{ ".ts",        "mpv --playlist-start={i} {F}" },
+	{ ".mts",       "mpv --playlist-start={i} {F}" },
+	{ ".mov",       "mpv --playlist-start={i} {F}" },
+	{ ".wmv",       "mpv --playlist-start={i} {F}" },
+	{ ".mov",       "mpv --playlist-start={i} {F}" },
+	{ ".amv",       "mpv --playlist-start={i} {F}" },
+	{ ".mp4",       "mpv --playlist-start={i} {F}" },
+	{ ".m4p",       "mpv --playlist-start={i} {F}" },
+	{ ".m4v",       "mpv --playlist-start={i} {F}" },
+	{ ".mpg",       "mpv --playlist-start={i} {F}" },
+	{ ".mpeg",      "mpv --playlist-start={i} {F}" },
+	{ ".mpv",       "mpv --playlist-start={i} {F}" },
 
 	/* audios */
-	{ ".wav",       "mpv --player-operation-mode=pseudo-gui {f} > /dev/null 2>&1" },
-	{ ".aiff",      "mpv --player-operation-mode=pseudo-gui {f} > /dev/null 2>&1" },
-	{ ".au",        "mpv --player-operation-mode=pseudo-gui {f} > /dev/null 2>&1" },
-	{ ".m4a",       "mpv --player-operation-mode=pseudo-gui {f} > /dev/null 2>&1" },
-	{ ".flac",      "mpv --player-operation-mode=pseudo-gui {f} > /dev/null 2>&1" },
-	{ ".mp3",       "mpv --player-operation-mode=pseudo-gui {f} > /dev/null 2>&1" },
-	{ ".aac",       "mpv --player-operation-mode=pseudo-gui {f} > /dev/null 2>&1" },
+	{ ".wav",       "mpv --player-operation-mode=pseudo-gui --playlist-start={i} {F}" },
+	{ ".aiff",      "mpv --player-operation-mode=pseudo-gui --playlist-start={i} {F}" },
+	{ ".au",        "mpv --player-operation-mode=pseudo-gui --playlist-start={i} {F}" },
+	{ ".m4a",       "mpv --player-operation-mode=pseudo-gui --playlist-start={i} {F}" },
+	{ ".flac",      "mpv --player-operation-mode=pseudo-gui --playlist-start={i} {F}" },
+	{ ".mp3",       "mpv --player-operation-mode=pseudo-gui --playlist-start={i} {F}" },
+	{ ".aac",       "mpv --player-operation-mode=pseudo-gui --playlist-start={i} {F}" },
 
 	/* ebooks */
-	{ ".epub",      "ebook-viewer {f} > /dev/null 2>&1" },
-	{ ".pdf",       "ebook-viewer {f} > /dev/null 2>&1" },
-	{ ".mobi",      "ebook-viewer {f} > /dev/null 2>&1" },
-	{ ".aws",       "ebook-viewer {f} > /dev/null 2>&1" },
+	{ ".epub",      "ebook-viewer {f}" },
+	{ ".pdf",       "ebook-viewer {f}" },
+	{ ".mobi",      "ebook-viewer {f}" },
+	{ ".aws",       "ebook-viewer {f}" },
 };
 
 # endif
@@ -0,0 +1,237 @@
+# ifndef CONTROL_H
+# define CONTROL_H
+
+struct control_client {
+	int fd;
+	std::string input;
+	std::string output;
+
+	// sent everything it will, it is answered before it is closed
+	bool finished = false;
+};
+
+struct control_request {
+	int client;
+	std::string line;
+};
+
+// a unix socket other programs drive odyssey through, its path is in
+// $ODYSSEY_SOCKET. every line is a command as typed after : or a query
+// starting with ?, every line is answered with one line of json. only
+// the owner can connect, the socket is made 0600
+class control_socket {
+	private:
+
+		int fd = -1;
+		std::vector<control_client> clients;
+
+		static std::string &path() {
+			static std::string instance;
+			return instance;
+		}
+
+		static void unlink_path() {
+			if(!path().empty()) {
+				unlink(path().c_str());
+			}
+		}
+
+		void disconnect(std::size_t index) {
+			close(clients[index].fd);
+			clients.erase(clients.begin() + index);
+		}
+
+		// writes what it can, the rest waits for POLLOUT
+		void flush(control_client &client) {
+			while(!client.output.empty()) {
+				stats::syscalls++;
+				ssize_t written = send(client.fd, client.output.data(), client.output.length(), MSG_NOSIGNAL);
+				if(written <= 0) {
+					return;
+				}
+				client.output.erase(0, written);
+			}
+		}
+
+	public:
+
+		control_socket() {
+			const char *runtime = getenv("XDG_RUNTIME_DIR");
+			std::string directory = runtime != nullptr && runtime[0] != '\0' ? runtime : "/tmp";
+			std::string filename = directory + "/odyssey." + std::to_string(getpid()) + ".sock";
+
+			struct sockaddr_un address;
+			memset(&address, 0, sizeof(address));
+			address.sun_family = AF_UNIX;
+			if(filename.length() >= sizeof(address.sun_path)) {
+				return;
+			}
+			strcpy(address.sun_path, filename.c_str());
+
+			fd = socket(AF_UNIX, SOCK_STREAM | SOCK_NONBLOCK | SOCK_CLOEXEC, 0);
+			if(fd == -1) {
+				return;
+			}
+
+			// a socket left behind by a crashed odyssey with the same pid
+			unlink(filename.c_str());
+
+			mode_t mask = umask(0177);
+			bool bound = bind(fd, reinterpret_cast<struct sockaddr*>(&address), sizeof(address)) == 0;
+			umask(mask);
+
+			if(!bound || listen(fd, control_backlog) != 0) {
+				close(fd);
+				fd = -1;
+				return;
+			}
+
+			// quit leaves through exit, the socket is removed there
+			path() = filename;
+			atexit(unlink_path);
+			setenv("ODYSSEY_SOCKET", filename.c_str(), 1);
+		}
+
+		~control_socket() {
+			for(const auto &client : clients) {
+				close(client.fd);
+			}
+			if(fd != -1) {
+				close(fd);
+				unlink_path();
+				path().clear();
+			}
+		}
+
+		// the descriptors to poll, the listening one and every client
+		void descriptors(std::vector<struct pollfd> &result) const {
+			if(fd == -1) {
+				return;
+			}
+
+			result.push_back({ fd, POLLIN, 0 });
+			for(const auto &client : clients) {
+				short events = (client.finished ? 0 : POLLIN) | (client.output.empty() ? 0 : POLLOUT);
+				result.push_back({ client.fd, events, 0 });
+			}
+		}
+
+		// accepts new clients and reads every complete line waiting on any
+		// of them, so a burst of commands comes back as one batch
+		std::vector<control_request> read() {
+			std::vector<control_request> requests;
+			if(fd == -1) {
+				return requests;
+			}
+
+			while(true) {
+				stats::syscalls++;
+				int client = accept4(fd, nullptr, nullptr, SOCK_NONBLOCK | SOCK_CLOEXEC);
+				if(client == -1) {
+					break;
+				}
+				clients.push_back({ client, "", "", false });
+			}
+
+			char buffer[65536];
+			for(std::size_t i = 0; i < clients.size();) {
+				control_client &client = clients[i];
+				flush(client);
+
+				bool failed = false;
+				while(!client.finished) {
+					stats::syscalls++;
+					ssize_t length = recv(client.fd, buffer, sizeof(buffer), 0);
+					if(length > 0) {
+						client.input.append(buffer, length);
+					} else {
+						client.finished = length == 0;
+						failed = length == -1 && errno != EAGAIN && errno != EWOULDBLOCK && errno != EINTR;
+						break;
+					}
+				}
+
+				// a last line without a newline still counts
+				if(client.finished && !client.input.empty() && client.input.back() != '\n') {
+					client.input += '\n';
+				}
+
+				std::size_t start = 0, end;
+				while((end = client.input.find('\n', start)) != std::string::npos) {
+					std::string line = client.input.substr(start, end - start);
+					if(!line.empty() && line.back() == '\r') {
+						line.pop_back();
+					}
+					if(!line.empty()) {
+						requests.push_back({ client.fd, line });
+					}
+					start = end + 1;
+				}
+				client.input.erase(0, start);
+
+				// a client that never ends its line is not buffered forever
+				if(failed || client.input.length() > control_line_limit) {
+					disconnect(i);
+				} else {
+					i++;
+				}
+			}
+
+			return requests;
+		}
+
+		// answers a request, dropped if its client left meanwhile
+		void reply(int client, const std::string &json) {
+			for(auto &candidate : clients) {
+				if(candidate.fd == client) {
+					candidate.output += json + "\n";
+					flush(candidate);
+					return;
+				}
+			}
+		}
+
+		// closes clients that are done once they have every answer
+		void sweep() {
+			for(std::size_t i = 0; i < clients.size();) {
+				flush(clients[i]);
+				if(clients[i].finished && clients[i].output.empty()) {
+					disconnect(i);
+				} else {
+					i++;
+				}
+			}
+		}
+
+		static std::string quote(const std::string &text) {
+			std::string result = "\"";
+			for(unsigned char character : text) {
+				switch(character) {
+					case '"' : result += "\\\""; break;
+					case '\\' : result += "\\\\"; break;
+					case '\n' : result += "\\n"; break;
+					case '\t' : result += "\\t"; break;
+					case '\r' : result += "\\r"; break;
+					default :
+						if(character < 0x20) {
+							char escaped[8];
+							snprintf(escaped, sizeof(escaped), "\\u%04x", character);
+							result += escaped;
+						} else {
+							result += character;
+						}
+				}
+			}
+			return result + "\"";
+		}
+
+		static std::string quote(const std::vector<std::string> &texts) {
+			std::string result = "[";
+			for(const auto &text : texts) {
+				result += (result.length() == 1 ? "" : ",") + quote(text);
+			}
+			return result + "]";
+		}
+};
+
+# endif
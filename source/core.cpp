@@ -2,6 +2,24 @@
 # include <experimental/filesystem>
 # include <boost/filesystem.hpp>
 # include <sys/stat.h>
+# include <sys/resource.h>
+# include <sys/mman.h>
+# include <sys/file.h>
+# include <fcntl.h>
+# include <unistd.h>
+# include <sys/syscall.h>
+# include <sys/inotify.h>
+# include <poll.h>
+# include <spawn.h>
+# include <signal.h>
+# include <sys/signalfd.h>
+# include <sys/wait.h>
+# include <sys/socket.h>
+# include <sys/un.h>
+# include <sys/eventfd.h>
+# include <sys/statvfs.h>
+# include <sys/sysmacros.h>
+# include <linux/io_uring.h>
 # include <algorithm>
 # include <ncurses.h>
 # include <iostream>
@@ -12,10 +30,29 @@
 # include <fstream>
 # include <chrono>
 # include <vector>
+# include <list>
+# include <deque>
+# include <map>
+# include <set>
+# include <memory>
+# include <limits>
+# include <limits.h>
+# include <string_view>
+# include <unordered_map>
+# include <unordered_set>
 # include <string>
 # include <pwd.h>
+# include <fnmatch.h>
+# include <dirent.h>
+# include <regex.h>
 # include <grp.h>
 # include <array>
+# include <atomic>
+# include <thread>
+# include <mutex>
+# include <condition_variable>
+# include <functional>
+# include <cstring>
 
 static constexpr int BLACK    = COLOR_PAIR(1);
 static constexpr int RED      = COLOR_PAIR(2);
@@ -38,6 +75,15 @@ enum action {
 	CD,
 	SET,
 	HIDDEN,
+	PARENT,
+	LONGLISTING,
+	GITSTATUS,
+	TREE,
+	EXPAND,
+	DUPES,
+	LINK,
+	COMPARE,
+	SYNC,
 	MKDIR,
 	OPEN,
 	MOVE,
@@ -46,15 +92,35 @@ enum action {
 	REMOVE,
 	TOUCH,
 	SELECT,
+	SELECTALL,
+	INVERT,
+	UNSELECT,
+	SELECTRANGE,
+	SELECTGLOB,
+	SELECTREGEX,
 	COPY,
 	COPYDIR,
 	PASTE,
+	YANK,
+	REGISTERS,
+	JOBS,
+	PLAYLIST,
+	REPEAT,
 	TOP,
 	BOTTOM,
 	SHELL,
 	RENAME,
 	EXTRACT,
 	COMPRESS,
+	STATS,
+	TRACE,
+	CACHESTATS,
+	TABNEW,
+	TAB,
+	TABNEXT,
+	TABPREV,
+	TABCLOSE,
+	JUMP,
 };
 
 struct colors {
@@ -76,45 +142,159 @@ struct event {
 struct open {
 	std::string extension;
 	std::string command;
+
+	// takes over the terminal until it exits instead of running beside
+	bool terminal = false;
 };
 
 # include "config.h"
 
 class user_interface;
+class listing;
 
 # include "commands.h"
+# include "stats.h"
+# include "surface.h"
+# include "mounts.h"
+# include "reader.h"
+# include "batch.h"
+# include "vfs.h"
+# include "guard.h"
+# include "watch.h"
+# include "cache.h"
+# include "selection.h"
+# include "history.h"
+# include "frecency.h"
+# include "registers.h"
+# include "children.h"
+# include "control.h"
+# include "metadata.h"
+# include "git.h"
+# include "tree.h"
+# include "dupes.h"
+# include "compare.h"
+
+// everything a tab keeps while it is not shown
+struct tab {
+	std::string path;
+
+	std::shared_ptr<const listing> main_elements = empty_listing;
+	std::shared_ptr<const listing> preview_elements = empty_listing;
+	std::vector<std::string> preview_lines;
+
+	int cursor = 0;
+	selection marks;
+	int scroll = 0;
+};
+
+# include "bench.h"
 
 class user_interface {
 	private:
 
-		WINDOW *main_window;
-		WINDOW *preview_window;
+		// first, it blocks SIGCHLD before threads are started
+		child_table children;
+
+		surface *screen = nullptr;
+		surface *parent_window = nullptr;
+		surface *main_window = nullptr;
+		surface *preview_window = nullptr;
+
+		// listings are shared with the cache, never copied
+		std::shared_ptr<const listing> parent_elements = empty_listing;
+		std::shared_ptr<const listing> main_elements = empty_listing;
+		std::shared_ptr<const listing> preview_elements = empty_listing;
+
+		// lines of the previewed file
+		std::vector<std::string> preview_lines;
+
+		listing_cache cache;
+
+		// long listing columns of the main listing
+		long_columns details;
 
-		std::vector<std::string> main_elements;
-		std::vector<std::string> preview_elements;
-		std::vector<std::string> main_sizes;
-		std::vector<std::string> preview_sizes;
+		// git status of the rows of the main listing
+		git_status git;
 
-		std::vector<std::string> file_history;
+		// directories expanded in the main pane
+		directory_tree tree;
+
+		// the last search for duplicate files
+		duplicate_finder dupes;
+
+		// the last comparison of the current directory with another
+		directory_compare compare;
+
+		// size sum of the main listing, summed once per listing off the ui
+		// thread and shown once it is done
+		struct size_sum {
+			std::shared_ptr<const listing> elements;
+			std::shared_ptr<std::atomic<bool>> finished;
+			std::shared_ptr<double> sum;
+		} sizes;
+
+		file_history history;
+		frecency_database frecency;
+		registers clipboard;
+		control_socket control;
 
 		std::vector<int> keys;
 		std::vector<unsigned long> key_times;
 
-		std::vector<int> selected = { 0 };
+		// count typed before a key, 0 without one
+		int count = 0;
+
+		// when the last frame was drawn, in microseconds
+		unsigned long last_render = 0;
+
+		// what . runs again
+		std::string last_command;
+		int last_count = 0;
+
+		int cursor = 0;
+		selection marks;
 
 		std::string file_info = "";
 		bool error_message = false;
 
+		// errors so far, a control request is answered with its own
+		int errors = 0;
+
 		int width, height;
 
 		int scroll = 0;
 
+		// directory shown by this tab, kept apart from the process cwd
+		std::string current_path;
+
+		// slot of the active tab is empty while it is active
+		std::vector<tab> tabs = { tab() };
+		int current_tab = 0;
+
 		unsigned long current_time() {
 			return std::chrono::duration_cast<std::chrono::milliseconds>
 				(std::chrono::system_clock::now().time_since_epoch()).count();
 		}
 
+		// runs the command of a key with the count typed before it
+		void dispatch(std::string command) {
+			int count_ = count;
+			count = 0;
+			commands::process_command(command, this, count_);
+		}
+
 		void add_key(int key) {
+			// counts like 50j, a 0 can only continue one
+			if(keys.empty() && ((key >= '1' && key <= '9') || (key == '0' && count != 0))) {
+				count = std::min(count * 10 + (key - '0'), max_count);
+				return;
+			} else if(key == 27) {
+				count = 0;
+				keys.clear();
+				key_times.clear();
+				return;
+			}
+
 			// handles double keys
 			for(int i = 0; i < keys.size(); i++) {
 				for(int j = 0; j < event_map.size(); j++) {
@@ -132,7 +312,7 @@ class user_interface {
 						key_times.erase(key_times.begin() + i);
 
 						if(flag) {
-							commands::process_command(event_map[j].command, this);
+							dispatch(event_map[j].command);
 							return;
 						}
 					}
@@ -142,7 +322,7 @@ class user_interface {
 			// handles regular keys
 			for(int i = 0; i < event_map.size(); i++) {
 				if(event_map[i].key == key && event_map[i].double_key == -1) {
-					commands::process_command(event_map[i].command, this);
+					dispatch(event_map[i].command);
 					return;
 				}
 			}
@@ -155,43 +335,90 @@ class user_interface {
 					return;
 				}
 			}
+
+			count = 0;
 		}
 
 		// update graphics
 		void update() {
 			commands::load({"preview"}, this);
 
-			// draw bottom message
-			if(error_message) {
-				wattron(stdscr, COLOR_PAIR(9));
-			}
+			scoped_timer timer("render");
 
-			mvwprintw(stdscr, LINES - 1, 0, file_info.c_str());
-			wattroff(stdscr, COLOR_PAIR(9));
+			// draw bottom message
+			screen->print(get_lines() - 1, 0, file_info, error_message ? COLOR_PAIR(9) : 0);
 
 			error_message = false;
 
 			draw_current_directory();
-			draw_elements(main_elements, main_sizes, main_window, true);
-			draw_elements(preview_elements, preview_sizes, preview_window, false);
+
+			if(show_parent) {
+				draw_parent();
+			}
+
+			if(show_long_listing) {
+				details.prepare(main_elements, current_path, scroll, main_window->get_height());
+			}
+
+			if(show_git_status) {
+				git.prepare(main_elements, current_path, scroll, main_window->get_height());
+			}
+
+			draw_elements(*main_elements, main_window, scroll, cursor, true, show_long_listing ? &details : nullptr,
+					show_git_status ? &git : nullptr, show_tree && dupes.view(current_path) == nullptr && compare.view(current_path) == nullptr);
+
+			// preview is either a directory or the lines of a file
+			if(!main_elements->empty() && main_elements->name(cursor).back() == '/') {
+				draw_elements(*preview_elements, preview_window, 0, -1, false);
+			} else {
+				draw_lines(preview_lines, preview_window);
+			}
 
 			handle_empty_directory();
+
+			if(stats::overlay) {
+				draw_stats();
+			}
 			
 			refresh_windows();
 		}
 
+		// draws the stats overlay in the top right corner of the preview
+		void draw_stats() {
+			std::vector<std::string> lines = stats::overlay_lines();
+
+			int stats_width = 0;
+			for(const auto &line : lines) {
+				stats_width = std::max(stats_width, static_cast<int>(line.length()) + 2);
+			}
+
+			if(stats_width > preview_window->get_width()) {
+				return;
+			}
+
+			for(int i = 0; i < lines.size(); i++) {
+				preview_window->print(i, preview_window->get_width() - stats_width,
+						" " + lines[i] + std::string(stats_width - lines[i].length() - 1, ' '), A_REVERSE);
+			}
+		}
+
 		void handle_frame() {
+			stats::next_frame();
 			clear_windows();
 
 			width = COLS;
 			height = LINES;
 
 			update();
+			last_render = stats::now();
+
+			stats::begin_idle();
 
 			int key;
 			while(key = getch()) {
 				if(key != ERR) {
-					add_key(key);
+					stats::end_idle();
+					handle_keys(key);
 					break;
 				}
 
@@ -200,258 +427,600 @@ class user_interface {
 					height = LINES;
 					update();
 				}
+
+				if(cache.apply(false) || fs_guard::recovered()) {
+					git.changed();
+					reload();
+				}
+
+				// an expanded directory was read
+				if(tree.collect(cache)) {
+					reload();
+				}
+
+				// a search for duplicates finished, its groups are shown
+				if(dupes.collect()) {
+					set_message(dupes.describe());
+					reload();
+				}
+
+				// differences of a comparison came in
+				if(compare.collect()) {
+					set_message(compare.describe());
+					reload();
+				}
+
+				// a scan finished or the index may have been written
+				if(git.collect() || (show_git_status && git.due())) {
+					update();
+				}
+
+				if(handle_requests()) {
+					clear_screen();
+					clear_windows();
+					update();
+				}
+
+				std::vector<std::string> failed = children.reap();
+				if(!failed.empty()) {
+					set_error_message(failed.back());
+					update();
+				}
+
+				wait_for_input();
+			}
+		}
+
+		// +1 or -1 if the key moves the cursor on its own, 0 otherwise
+		int movement(int key) {
+			if(!keys.empty() || count != 0) {
+				return 0;
+			}
+
+			for(const auto &binding : event_map) {
+				if(binding.key == key && binding.double_key == -1) {
+					return binding.command == "down" ? 1 : binding.command == "up" ? -1 : 0;
+				}
+			}
+			return 0;
+		}
+
+		// handles a key and every key already waiting behind it before the
+		// next frame is drawn, a held or pasted key costs one render. moves
+		// up and down in a row become one move. frames are at most
+		// max_frame_rate a second, keys coming in meanwhile join this one
+		void handle_keys(int key) {
+			int moves = 0;
+
+			auto move = [&]() {
+				if(moves != 0) {
+					commands::process_command(moves > 0 ? "down" : "up", this, std::abs(moves));
+					moves = 0;
+				}
+			};
+
+			while(key != ERR) {
+				stats::count_key();
+
+				int direction = movement(key);
+				if(direction != 0) {
+					moves += direction;
+				} else {
+					move();
+					add_key(key);
+				}
+
+				key = getch();
+				if(key == ERR) {
+					long wait = static_cast<long>(last_render + 1000000 / max_frame_rate) - static_cast<long>(stats::now());
+					if(wait > 0) {
+						struct pollfd descriptor = { STDIN_FILENO, POLLIN, 0 };
+
+						stats::begin_idle();
+						stats::syscalls++;
+						if(poll(&descriptor, 1, wait / 1000 + 1) > 0) {
+							key = getch();
+						}
+						stats::end_idle();
+					}
+				}
+			}
+
+			move();
+		}
+
+		// answers a query of the control socket as json
+		std::string query(const std::string &name) {
+			if(name == "path") {
+				return "{\"ok\":true,\"path\":" + control_socket::quote(current_path) + "}";
+			} else if(name == "cursor") {
+				std::string file = main_elements->empty() ? "" : full_path((*main_elements)[cursor]);
+				return "{\"ok\":true,\"cursor\":" + std::to_string(cursor) + ",\"file\":" + control_socket::quote(file) + "}";
+			} else if(name == "selection") {
+				std::vector<std::string> paths;
+				for(int i : marks.indices()) {
+					paths.push_back(full_path((*main_elements)[i]));
+				}
+				return "{\"ok\":true,\"selection\":" + control_socket::quote(paths) + "}";
+			} else if(name == "listing") {
+				std::vector<std::string> names;
+				names.reserve(main_elements->size());
+				for(std::size_t i = 0; i < main_elements->size(); i++) {
+					names.push_back((*main_elements)[i]);
+				}
+				return "{\"ok\":true,\"listing\":" + control_socket::quote(names) + "}";
 			}
+			return "{\"ok\":false,\"error\":" + control_socket::quote("Unknown query \"" + name + "\"") + "}";
+		}
+
+		// runs what came in on the control socket as one batch. listings are
+		// only loaded again before a request that looks at them and once at
+		// the end, the screen is drawn once. true if anything came in
+		bool handle_requests() {
+			std::vector<control_request> requests = control.read();
+			if(requests.empty()) {
+				control.sweep();
+				return false;
+			}
+
+			scoped_timer timer("control");
+			bool stale = false;
+
+			for(const auto &request : requests) {
+				std::vector<std::string> args = split_into_args(request.line);
+
+				// these name what they work on and do not look at the listings
+				bool blind = args.size() > 1 && (args[0] == "cd" || args[0] == "mkdir"
+						|| args[0] == "touch" || args[0] == "z" || args[0] == "sh");
+
+				if(stale && !blind) {
+					commands::load_listings(this);
+					stale = false;
+				}
+
+				if(request.line[0] == '?') {
+					control.reply(request.client, query(request.line.substr(1)));
+					continue;
+				}
+
+				int errors_before = errors;
+				stale = commands::run_command(request.line, this) || stale;
+
+				control.reply(request.client, errors == errors_before ? "{\"ok\":true}"
+						: "{\"ok\":false,\"error\":" + control_socket::quote(file_info) + "}");
+			}
+
+			if(stale) {
+				commands::load_listings(this);
+			}
+			control.sweep();
+			return true;
+		}
+
+		// shows listings patched while idle, the cursor stays on its file
+		void reload() {
+			std::string selected = main_elements->empty() ? "" : (*main_elements)[cursor];
+
+			commands::load({"main"}, this);
+			set_cursor(selected);
+			bound_selected();
+			commands::load({"parent"}, this);
+			commands::load({"preview"}, this);
+
+			clear_windows();
+			update();
+		}
+
+		// sleeps until a key, a directory change, an exited child, a finished
+		// git scan, tree read, search or comparison, a control request or a resize, which
+		// interrupts poll with SIGWINCH
+		void wait_for_input() {
+			std::vector<struct pollfd> descriptors = {
+				{ STDIN_FILENO, POLLIN, 0 },
+				{ children.get_fd(), POLLIN, 0 },
+				{ cache.get_watch_fd(), POLLIN, 0 },
+				{ git.get_fd(), POLLIN, 0 },
+				{ tree.get_fd(), POLLIN, 0 },
+				{ dupes.get_fd(), POLLIN, 0 },
+				{ compare.get_fd(), POLLIN, 0 },
+				{ fs_guard::get_fd(), POLLIN, 0 },
+			};
+			control.descriptors(descriptors);
+
+			long time_left = cache.time_left();
+			int timeout = time_left == -1 ? idle_timeout : static_cast<int>(time_left / 1000) + 1;
+
+			stats::syscalls++;
+			poll(descriptors.data(), descriptors.size(), timeout);
 		}
 
 		// draws EMPTY if directory is empty. also permission checks
 		void handle_empty_directory() {
-			if((main_elements.empty())
-			|| (preview_elements.empty()
-			&& boost::filesystem::is_directory(main_elements[selected[0]]))) {
+			if((main_elements->empty())
+			|| (preview_elements->empty() && preview_lines.empty()
+			&& main_elements->name(cursor).back() == '/')) {
 
-				WINDOW *empty_window;
+				surface *empty_window;
 
-				if(main_elements.empty()) {
+				if(main_elements->empty()) {
 					empty_window = main_window;
 				} else {
 					empty_window = preview_window;
 				}
 
-				wattron(empty_window, COLOR_PAIR(9));
-				mvwprintw(empty_window, 0, 0, "EMPTY");
-				wattroff(empty_window, COLOR_PAIR(9));
+				const listing &empty = main_elements->empty() ? *main_elements : *preview_elements;
+				empty_window->print(0, 0, !empty.responsive ? "UNRESPONSIVE" : !empty.complete ? "LOADING" : "EMPTY", COLOR_PAIR(9));
 			}
 
-			if(!main_elements.empty() && preview_elements.empty()) {
-				boost::system::error_code error;
-				for(const auto &entry : boost::filesystem::directory_iterator(main_elements[selected[0]], error));
+			if(!main_elements->empty() && preview_elements->empty() && preview_lines.empty()
+			&& preview_elements->responsive && main_elements->name(cursor).back() == '/') {
+
+				std::string path = full_path((*main_elements)[cursor]);
+				std::shared_ptr<bool> denied = std::make_shared<bool>(false);
 
-				if(error.value() == 13) {
-					wattron(preview_window, COLOR_PAIR(9));
-					mvwprintw(preview_window, 0, 0, "NO PERIMISSIONS TO FOLDER");
-					wattroff(preview_window, COLOR_PAIR(9));
+				if(fs_guard::run(path, [path, denied]() {
+					stats::syscalls++;
+					*denied = access(path.c_str(), R_OK) != 0 && errno == EACCES;
+				}) && *denied) {
+					preview_window->print(0, 0, "NO PERIMISSIONS TO FOLDER", COLOR_PAIR(9));
 				}
 			}
 		}
 
+		// lays the columns out by their ratios, one space between each
 		void refresh_windows() {
-			wresize(main_window, LINES - 3, COLS / 2 - 1);
-			wresize(preview_window, LINES - 3, COLS / 2 - 2);
-			mvwin(main_window, 2, 1);
-			mvwin(preview_window, 2, (COLS / 2) + 1);
-
-			wrefresh(main_window);
-			wrefresh(preview_window);
-		}
+			std::vector<surface*> columns = { parent_window, main_window, preview_window };
+			std::vector<int> ratios = column_ratios;
 
-		// draw the current directory at top
-		void draw_current_directory() {
-			std::string current_path = boost::filesystem::current_path().string();
+			if(!show_parent) {
+				columns.erase(columns.begin());
+				ratios.erase(ratios.begin());
+			}
 
-			mvwprintw(stdscr, 0, 0, std::string(COLS, ' ').c_str());
-			mvwprintw(stdscr, 0, 0, current_path.c_str());
+			int total = 0;
+			for(int ratio : ratios) {
+				total += ratio;
+			}
 
-			wattron(stdscr, A_BOLD);
+			int sum = 0;
+			for(int i = 0; i < columns.size(); i++) {
+				int begin = get_columns() * sum / total + 1;
+				sum += ratios[i];
+				int end = i == columns.size() - 1 ? get_columns() - 1 : get_columns() * sum / total;
 
-			if(!main_elements.empty()) {
-				mvwprintw(stdscr, 0, current_path.length(),
-						std::string((current_path != "/" ? "/" : "") + main_elements[selected[0]]).c_str());
+				columns[i]->move(2, begin, get_lines() - 3, end - begin);
 			}
 
-			wattroff(stdscr, A_BOLD);
+			screen->refresh();
+			for(surface *column : columns) {
+				column->refresh();
+			}
 		}
 
-		// chooses color for a filename
-		void handle_colors(std::string selected_file) {
-			for(int i = 0; i < colors_map.size(); i++) {
-				boost::filesystem::path path_object(selected_file);
+		// draw the current directory at top
+		void draw_current_directory() {
+			screen->print(0, 0, std::string(get_columns(), ' '));
+			screen->print(0, 0, current_path);
 
-				if((colors_map[i].extension == path_object.extension().string())
-				|| (colors_map[i].extension == "dir"
-				&& boost::filesystem::is_directory(selected_file))
-				|| (colors_map[i].extension == "")) {
+			if(!main_elements->empty()) {
+				screen->print(0, current_path.length(),
+						(current_path != "/" ? "/" : "") + (*main_elements)[cursor], A_BOLD);
+			}
 
-					wattron(main_window, colors_map[i].color);
-					wattron(preview_window, colors_map[i].color);
-					return;
+			// tab numbers on the right, active one highlighted
+			if(tabs.size() > 1) {
+				int draw_x = get_columns();
+				for(int i = tabs.size() - 1; i >= 0; i--) {
+					std::string number = " " + std::to_string(i + 1) + " ";
+					draw_x -= number.length();
+					screen->print(0, draw_x, number, i == current_tab ? A_REVERSE : 0);
 				}
 			}
 		}
 
-		// turns off every color
-		void colors_off() {
-			wattroff(main_window, A_REVERSE|BRIGHT|BLINK);
-			wattroff(preview_window, A_REVERSE|BRIGHT|BLINK);
-			for(int i = 1; i < 8; i++) {
-				wattroff(main_window, COLOR_PAIR(i));
-				wattroff(preview_window, COLOR_PAIR(i));
-			}
+		// exchanges the shown state with a stored tab, no copies
+		void swap_tab(tab &other) {
+			std::swap(current_path, other.path);
+			std::swap(main_elements, other.main_elements);
+			std::swap(preview_elements, other.preview_elements);
+			std::swap(preview_lines, other.preview_lines);
+			std::swap(cursor, other.cursor);
+			std::swap(marks, other.marks);
+			std::swap(scroll, other.scroll);
 		}
 
-		// thicc chunker
-		void draw_elements(std::vector<std::string> elements,
-						   std::vector<std::string> sizes,
-						   WINDOW *window,
-						   bool main_window) {
+		// chooses color for a filename, directories end with a slash
+		int handle_colors(std::string_view filename) {
+			bool directory = !filename.empty() && filename.back() == '/';
 
-			int y, x;
-			getmaxyx(window, y, x);
-			y -= 3;
+			std::string_view extension;
+			std::size_t dot = filename.find_last_of('.');
+			if(!directory && dot != std::string_view::npos && dot != 0) {
+				extension = filename.substr(dot);
+			}
 
-			// if main window then account for scroll
-			for(int i = 0; main_window ? i + scroll < elements.size() : i < elements.size(); i++) {
+			for(int i = 0; i < colors_map.size(); i++) {
+				if((!directory && colors_map[i].extension == extension)
+				|| (colors_map[i].extension == "dir" && directory)
+				|| (colors_map[i].extension == "")) {
 
-				int index = main_window ? i + scroll : i;
+					return colors_map[i].color;
+				}
+			}
+			return 0;
+		}
 
-				if(main_window
-				|| (!main_window
-				&& boost::filesystem::is_directory(main_elements[selected[0]]))) {
+		// parent column, scrolled so the current directory is visible
+		void draw_parent() {
+			std::string name = boost::filesystem::path(current_path).filename().string() + "/";
+			int highlighted = parent_elements->find(name);
 
-					int draw_x = 0;
+			int parent_scroll = std::max(0, highlighted - parent_window->get_height() / 2);
+			draw_elements(*parent_elements, parent_window, parent_scroll, highlighted, false);
+		}
 
-					// highlight selected
-					if(main_window && selected[0] == i + scroll) {
-						wattron(window, A_REVERSE);
-					}
+		// thicc chunker
+		void draw_elements(const listing &elements,
+						   surface *window,
+						   int scroll,
+						   int highlighted,
+						   bool show_marks,
+						   const long_columns *columns = nullptr,
+						   const git_status *status = nullptr,
+						   bool indent = false) {
+
+			int x = window->get_width();
+
+			// long listing columns only when a name still fits next to them
+			int prefix_width = columns != nullptr && x > long_columns::width() + 16 ? long_columns::width() + 1 : 0;
+			x -= prefix_width;
+
+			// only the visible slice is drawn
+			for(int i = 0; i + scroll < elements.size() && i < window->get_height(); i++) {
+				int index = i + scroll;
+				int draw_x = 0;
+				int attributes = 0;
+
+				// highlight selected
+				if(index == highlighted) {
+					attributes |= A_REVERSE;
+				}
 
-					// tab other selected
-					if(main_window
-					&& std::find(selected.begin() + 1, selected.end(), i + scroll)
-					!= selected.end()) {
+				// tab other selected
+				if(show_marks && marks.test(index)) {
 
-						draw_x = selected_space_size;
-					}
+					draw_x = selected_space_size;
+				}
 
-					// draw colors
-					if(main_window) {
-						handle_colors(elements[index]);
-					} else {
-						handle_colors(main_elements[selected[0]] + "/" + elements[index]);
-					}
+				std::string_view name = elements.name(index);
+				std::string_view size = elements.file_size(index);
+
+				// rows of expanded directories are indented by their depth
+				std::string shown;
+				std::string_view base = name;
+				std::size_t slash = name.find_last_of('/', name.length() - 2);
+				if(indent && name.length() > 1 && slash != std::string_view::npos) {
+					std::size_t depth = std::count(name.begin(), name.begin() + slash + 1, '/');
+					base = name.substr(slash + 1);
+					shown.assign(depth * 2, ' ').append(base);
+					name = shown;
+				}
 
-					std::string size = sizes[index];
-
-					// meat
-					if(elements[index].length() + size.length() + draw_x < x) {
-						mvwprintw(window, i, draw_x, std::string(
-								elements[index] + std::string(
-								x - elements[index].length() - size.length() - draw_x, ' ')
-							   	+ size).c_str());
-					} else {
-						mvwprintw(window, i, draw_x, std::string(elements[index].substr(
-							0, x - size.length() - 4 - draw_x + 2) + "~ " + size).c_str());
+				// draw colors, files git would list stand out from their type
+				int color = handle_colors(base);
+				if(status != nullptr) {
+					git_state state = status->state(index);
+					for(const auto &git_color : git_colors) {
+						if(git_color.first == state) {
+							color = git_color.second;
+						}
 					}
+				}
+				attributes |= color;
 
-					colors_off();
+				// meat
+				std::string line;
+				if(name.length() + size.length() + draw_x < x) {
+					line.append(name).append(x - name.length() - size.length() - draw_x, ' ').append(size);
 				} else {
-					std::string line = elements[index];
-					line = commands::find_and_replace(line, "%", "%%");
-					mvwprintw(window, i, 0, line.c_str());
+					line.append(name.substr(0, x - size.length() - 4 - draw_x + 2)).append("~ ").append(size);
 				}
+				if(prefix_width != 0) {
+					std::string prefix(columns->row(index));
+					prefix.resize(prefix_width, ' ');
+					line.insert(0, prefix);
+				}
+				window->print(i, draw_x, line, attributes);
+			}
+		}
+
+		void draw_lines(const std::vector<std::string> &lines, surface *window) {
+			for(int i = 0; i < lines.size() && i < window->get_height(); i++) {
+				window->print(i, 0, lines[i]);
 			}
 		}
 
 	public:
 
 		void bound_selected() {
-			int y, x;
-			getmaxyx(main_window, y, x);
+			int y = main_window->get_height();
 			clear_windows();
 
-			scroll = selected[0] < scroll && scroll != 0 ? scroll - 1 :
-				selected[0] < main_elements.size()
-				&& selected[0] > scroll + y - 1 ? scroll + 1 : scroll;
+			cursor = cursor < 0 ? 0 :
+				cursor > main_elements->size() - 1 ?
+				main_elements->size() - 1 : cursor;
+
+			// the cursor can move any distance at once, scroll follows it all the way
+			scroll = cursor < scroll ? cursor :
+				cursor > scroll + y - 1 ? cursor - y + 1 : scroll;
+			scroll = std::max(scroll, 0);
+		}
+
+		file_history &get_file_history() {
+			return history;
+		}
+
+		frecency_database &get_frecency() {
+			return frecency;
+		}
 
-			selected[0] = selected[0] < 0 ? 0 :
-				selected[0] > main_elements.size() - 1 ?
-				main_elements.size() - 1 : selected[0];
+		registers &get_registers() {
+			return clipboard;
 		}
 
-		std::vector<std::string> get_file_history() {
-			return file_history;
+		child_table &get_children() {
+			return children;
 		}
 
-		void set_file_history(std::vector<std::string> file_history_) {
-			file_history = file_history_;
+		directory_tree &get_tree() {
+			return tree;
+		}
+
+		duplicate_finder &get_dupes() {
+			return dupes;
+		}
+
+		directory_compare &get_compare() {
+			return compare;
+		}
+
+		void set_last_command(std::string command, int count_) {
+			last_command = command;
+			last_count = count_;
+		}
+
+		std::string get_last_command() {
+			return last_command;
+		}
+
+		int get_last_count() {
+			return last_count;
 		}
 
 		void set_error_message(std::string error_message_) {
 			file_info = error_message_;
 			error_message = true;
+			errors++;
 		}
 
 		// thicc chunker
 		void load_file_info() {
+			scoped_timer timer("file info");
+
 			std::string selected_filename;
-			if(!main_elements.empty()) {
-				selected_filename = main_elements[selected[0]];
+			if(!main_elements->empty()) {
+				selected_filename = (*main_elements)[cursor];
 			}
 
 			file_info = "";
 
-			if(!main_elements.empty() && boost::filesystem::exists(selected_filename)) {
-				std::string file_sizes = commands::format_file_size(commands::file_sizes(
-							boost::filesystem::current_path().string()), size_precision) + " sum, ";
+			if(main_elements->empty()) {
+				return;
+			}
+
+			// gathered off the ui thread, the file may be on a mount that hangs.
+			// one statx answers every field shown below
+			struct details {
+				int error = 0;
+				struct statx info;
+				double free = -1;
+			};
+
+			std::shared_ptr<details> result = std::make_shared<details>();
+			std::string path = full_path(selected_filename);
+			std::string directory = current_path;
+
+			// summing a remote directory would stat every file in it. the sum
+			// is not waited for, the frame after it finished shows it. on a
+			// hung mount it is tried again with the next listing
+			if(sizes.elements != main_elements) {
+				std::shared_ptr<std::atomic<bool>> finished = std::make_shared<std::atomic<bool>>(false);
+				std::shared_ptr<double> sum = std::make_shared<double>(-1);
+
+				if(fs_guard::remote(directory) || fs_guard::start(directory, [finished, sum, directory]() {
+					*sum = commands::file_sizes(directory);
+					*finished = true;
+				}, false) != nullptr) {
+					sizes = { main_elements, finished, sum };
+				}
+			}
 
-				if(file_sizes.length() > COLS) {
+			if(!fs_guard::run(path, [result, path]() {
+				result->error = vfs::current().stat(path, result->info);
+				if(result->error != 0) {
+					return;
+				}
+
+				result->free = commands::free_space(path);
+			})) {
+				file_info = "UNRESPONSIVE";
+				return;
+			}
+
+			const struct statx &info = result->info;
+
+			if(result->error == 0) {
+				double sum = sizes.elements == main_elements && sizes.finished->load() ? *sizes.sum : -1;
+				std::string file_sizes = commands::format_file_size(sum, size_precision) + " sum, ";
+
+				if(file_sizes.length() > get_columns()) {
 					return;
 				}
 
 				std::string right_info = file_sizes;
-				std::string free_space = commands::format_file_size(
-						commands::free_space(selected_filename), size_precision) + " free, ";
+				std::string free_space = commands::format_file_size(result->free, size_precision) + " free, ";
 
-				if(right_info.length() + free_space.length() > COLS) {
+				if(right_info.length() + free_space.length() > get_columns()) {
 					file_info = right_info;
 					return;
 				}
 
 				right_info += free_space;
-				std::string position = std::to_string(selected[0] + 1) + "/" + std::to_string(main_elements.size());
+				std::string position = std::to_string(cursor + 1) + "/" + std::to_string(main_elements->size());
 
-				if(right_info.length() + position.length() > COLS) {
+				if(right_info.length() + position.length() > get_columns()) {
 					file_info = right_info;
 					return;
 				}
 
 				right_info += position;
-				std::string permissions = commands::file_permissions(selected_filename) + " ";
+				std::string permissions = commands::file_permissions(info.stx_mode) + " ";
 
-				if(right_info.length() + permissions.length() > COLS) {
-					file_info += std::string(COLS - file_info.length() - right_info.length(), ' ') + right_info;
+				if(right_info.length() + permissions.length() > get_columns()) {
+					file_info += std::string(get_columns() - file_info.length() - right_info.length(), ' ') + right_info;
 					return;
 				}
 
 				file_info += permissions;
-				std::string owner = commands::file_owner(selected_filename) + " ";
+				std::string owner = commands::file_owner(info.stx_uid, info.stx_gid) + " ";
 
-				if(file_info.length() + right_info.length() + owner.length() > COLS) {
-					file_info += std::string(COLS - file_info.length() - right_info.length(), ' ') + right_info;
+				if(file_info.length() + right_info.length() + owner.length() > get_columns()) {
+					file_info += std::string(get_columns() - file_info.length() - right_info.length(), ' ') + right_info;
 					return;
 				}
 
 				file_info += owner;
 
-				if(!boost::filesystem::is_directory(selected_filename)) {
-					std::string file_size = commands::format_file_size(commands::file_size(selected_filename), size_precision) + " ";
+				if(!S_ISDIR(info.stx_mode)) {
+					std::string file_size = commands::format_file_size(S_ISREG(info.stx_mode) ? static_cast<double>(info.stx_size) : -1, size_precision) + " ";
 
-					if(file_info.length() + right_info.length() + file_size.length() > COLS) {
-						file_info += std::string(COLS - file_info.length() - right_info.length(), ' ') + right_info;
+					if(file_info.length() + right_info.length() + file_size.length() > get_columns()) {
+						file_info += std::string(get_columns() - file_info.length() - right_info.length(), ' ') + right_info;
 						return;
 					}
 
 					file_info += file_size;
 				}
 
-				std::string mod_time = commands::file_last_mod_time(selected_filename) + " ";
+				std::string mod_time = commands::file_last_mod_time(info.stx_mtime.tv_sec) + " ";
 
-				if(file_info.length() + right_info.length() + mod_time.length() > COLS) {
-					file_info += std::string(COLS - file_info.length() - right_info.length(), ' ') + right_info;
+				if(file_info.length() + right_info.length() + mod_time.length() > get_columns()) {
+					file_info += std::string(get_columns() - file_info.length() - right_info.length(), ' ') + right_info;
 					return;
 				}
 				
 				file_info += mod_time;
-				file_info += std::string(COLS - file_info.length() - right_info.length(), ' ') + right_info;
+				file_info += std::string(get_columns() - file_info.length() - right_info.length(), ' ') + right_info;
 			}
 		}
 
@@ -463,7 +1032,9 @@ class user_interface {
 		// main loop
 		void loop() {
 			boost::filesystem::current_path(starting_directory);
+			current_path = boost::filesystem::current_path().string();
 			commands::load({"main"}, this);
+			commands::load({"parent"}, this);
 			commands::load({"preview"}, this);
 			load_file_info();
 
@@ -507,49 +1078,195 @@ class user_interface {
 			init_colors();
 			curs_set(0);
 
-			main_window = newwin(0, 0, 0, 0);
-			preview_window = newwin(0, 0, 0, 0);
+			screen = new ncurses_surface(stdscr);
+			parent_window = new ncurses_surface(newwin(0, 0, 0, 0));
+			main_window = new ncurses_surface(newwin(0, 0, 0, 0));
+			preview_window = new ncurses_surface(newwin(0, 0, 0, 0));
 
 			refresh_windows();
 		}
 
-		std::vector<int> get_selected() {
-			return selected;
+		// renders into memory instead of a terminal
+		void init_offscreen(int lines, int columns) {
+			screen = new memory_surface(lines, columns);
+			parent_window = new memory_surface(0, 0);
+			main_window = new memory_surface(0, 0);
+			preview_window = new memory_surface(0, 0);
+
+			refresh_windows();
+		}
+
+		~user_interface() {
+			delete parent_window;
+			delete main_window;
+			delete preview_window;
+			delete screen;
+		}
+
+		int get_lines() {
+			return screen->get_height();
+		}
+
+		int get_columns() {
+			return screen->get_width();
+		}
+
+		std::string get_current_path() {
+			return current_path;
+		}
+
+		void set_current_path(std::string current_path_) {
+			current_path = current_path_;
+		}
+
+		// forces the next load to read the directory again
+		void invalidate() {
+			cache.invalidate(current_path);
+		}
+
+		int get_tab_count() {
+			return tabs.size();
+		}
+
+		int get_current_tab() {
+			return current_tab;
+		}
+
+		void new_tab(std::string path) {
+			tabs.push_back(tab());
+			tabs.back().path = path;
+			switch_tab(tabs.size() - 1);
+		}
+
+		// restores a tab and follows it with the process cwd
+		bool switch_tab(int index) {
+			if(index < 0 || index >= tabs.size()) {
+				return false;
+			}
+
+			swap_tab(tabs[current_tab]);
+			current_tab = index;
+			swap_tab(tabs[current_tab]);
+
+			boost::system::error_code error;
+			boost::filesystem::current_path(current_path, error);
+			if(error) {
+				set_error_message("Cannot change directory \"" + current_path + "\" (" + error.message() + ")");
+			}
+
+			return true;
+		}
+
+		bool close_tab() {
+			if(tabs.size() == 1) {
+				return false;
+			}
+
+			int index = current_tab;
+			switch_tab(index == tabs.size() - 1 ? index - 1 : index + 1);
+			tabs.erase(tabs.begin() + index);
+
+			if(current_tab > index) {
+				current_tab--;
+			}
+
+			return true;
+		}
+
+		listing_cache *get_cache() {
+			return &cache;
+		}
+
+		// absolute path of an element of the main listing
+		std::string full_path(std::string filename) {
+			if(!filename.empty() && filename.back() == '/') {
+				filename.pop_back();
+			}
+			return (current_path == "/" ? "" : current_path) + "/" + filename;
+		}
+
+		surface *get_screen() {
+			return screen;
 		}
 
-		std::vector<std::string> get_main_elements() {
-			return main_elements;
+		surface *get_main_window() {
+			return main_window;
 		}
 
-		void set_selected(std::vector<int> selected_) {
-			selected = selected_;
+		surface *get_preview_window() {
+			return preview_window;
+		}
+
+		// one frame without waiting for input, used by benchmarks
+		void render() {
+			screen->clear();
+			clear_windows();
+			update();
+		}
+
+		int get_cursor() {
+			return cursor;
+		}
+
+		selection &get_selection() {
+			return marks;
+		}
+
+		const listing &get_main_elements() {
+			return *main_elements;
+		}
+
+		void set_cursor(int cursor_) {
+			cursor = cursor_;
 			bound_selected();
 			commands::load({"preview"}, this);
 			load_file_info();
 		}
 		
-		void set_main_elements(std::vector<std::string> main_elements_) {
+		// marks follow their inodes into the new listing
+		void set_main_elements(std::shared_ptr<const listing> main_elements_) {
+			if(main_elements_ == main_elements) {
+				return;
+			}
+
+			std::unordered_set<ino_t> marked;
+			for(int index : marks.indices()) {
+				marked.insert(main_elements->inode(index));
+			}
+
 			main_elements = main_elements_;
+			marks.reset(main_elements->size());
+
+			for(std::size_t i = 0; !marked.empty() && i < main_elements->size(); i++) {
+				if(marked.count(main_elements->inode(i))) {
+					marks.set(i, true);
+				}
+			}
+		}
+
+		void set_preview_elements(std::shared_ptr<const listing> preview_elements_) {
+			preview_elements = preview_elements_;
 		}
 
-		void set_main_sizes(std::vector<std::string> main_sizes_) {
-			main_sizes = main_sizes_;
+		void set_preview_lines(std::vector<std::string> preview_lines_) {
+			preview_lines = std::move(preview_lines_);
 		}
 
-		void set_preview_sizes(std::vector<std::string> preview_sizes_) {
-			preview_sizes = preview_sizes_;
+		void set_parent_elements(std::shared_ptr<const listing> parent_elements_) {
+			parent_elements = parent_elements_;
 		}
 
-		void set_preview_elements(std::vector<std::string> preview_elements_) {
-			preview_elements = preview_elements_;
+		// drops every mark
+		void clear_selection() {
+			marks.clear();
+			set_cursor(cursor);
 		}
 
-		void set_selected(std::string selected_) {
-			std::vector<std::string>::iterator iterator = std::find(
-					main_elements.begin(), main_elements.end(), selected_);
+		void set_cursor(std::string selected_) {
+			int index = main_elements->find(selected_);
 
-			if(iterator != main_elements.end()) {
-				selected[0] = std::distance(main_elements.begin(), iterator);
+			if(index != -1) {
+				cursor = index;
 			}
 
 			commands::load({"preview"}, this);
@@ -557,26 +1274,15 @@ class user_interface {
 		}
 
 		void clear_windows() {
-			int main_x, main_y, preview_x, preview_y;
-
-			getmaxyx(main_window, main_y, main_x);
-			getmaxyx(preview_window, preview_y, preview_x);
-
-			for(int i = 0; i < main_y; i++) {
-				mvwprintw(main_window, i, 0, std::string(main_x, ' ').c_str());
-			}
-
-			for(int i = 0; i < preview_y; i++) {
-				mvwprintw(preview_window, i, 0, std::string(preview_x, ' ').c_str());
-			}
+			parent_window->clear();
+			main_window->clear();
+			preview_window->clear();
 		}
 
 		void clear_screen() {
-			for(int i = 0; i < LINES; i++) {
-				mvwprintw(stdscr, i, 0, std::string(COLS, ' ').c_str());
-			}
+			screen->clear();
 			clear_windows();
-			refresh();
+			screen->refresh();
 		}
 
 		std::vector<std::string> split_into_args(std::string str) {
@@ -587,8 +1293,14 @@ class user_interface {
 };
 
 # include "commands.cpp"
+# include "stats.cpp"
+# include "bench.cpp"
+
+int main(int argc, char **argv) {
+	if(argc > 2 && std::string(argv[1]) == "--bench") {
+		return bench::run(std::vector<std::string>(argv + 2, argv + argc));
+	}
 
-int main() {
 	user_interface ui;
 	ui.init_ncurses();
 	ui.loop();
@@ -0,0 +1,433 @@
+# ifndef DUPES_H
+# define DUPES_H
+
+// files with the same content, largest waste first
+struct duplicate_group {
+	unsigned long size;
+	std::vector<std::pair<std::string, ino_t>> files;
+};
+
+// finds duplicate files below a set of paths. only files of the same size
+// can match, so most are ruled out by a stat. the rest are hashed on both
+// ends and only those still matching are read whole, on every core. names
+// of the same inode count once, they take no space twice. the groups are
+// shown as the main listing of the directory the search started in, with
+// paths relative to it, until it is closed
+class duplicate_finder {
+	private:
+
+		struct candidate {
+			std::string path;
+			ino_t inode;
+			unsigned long size;
+			std::uint64_t hash;
+			int error;
+		};
+
+		struct result {
+			std::string root;
+			std::vector<duplicate_group> groups;
+			unsigned long files;
+			unsigned long errors;
+		};
+
+		// the search that finished, handed over from its thread
+		struct finished_search {
+			std::mutex mutex;
+			std::unique_ptr<result> search;
+		};
+
+		std::shared_ptr<finished_search> finished = std::make_shared<finished_search>();
+		int fd = -1;
+		bool running = false;
+
+		std::string root;
+		std::vector<duplicate_group> groups;
+		std::unordered_map<std::string, std::size_t> group_of;
+		std::shared_ptr<const listing> shown;
+		std::string summary;
+
+		static std::string full_path(const std::string &root, const std::string &relative) {
+			return relative.empty() ? root : (root == "/" ? "" : root) + "/" + relative;
+		}
+
+		static std::uint64_t mix(std::uint64_t a, std::uint64_t b) {
+			unsigned __int128 product = static_cast<unsigned __int128>(a) * b;
+			return static_cast<std::uint64_t>(product) ^ static_cast<std::uint64_t>(product >> 64);
+		}
+
+		// 16 bytes per multiply, chained through seed across buffers
+		static std::uint64_t hash(const char *data, std::size_t length, std::uint64_t seed) {
+			constexpr std::uint64_t first = 0xa0761d6478bd642full, second = 0xe7037ed1a0b428dbull;
+
+			std::uint64_t words[2];
+			std::size_t i = 0;
+			for(; i + 16 <= length; i += 16) {
+				memcpy(words, data + i, 16);
+				seed = mix(words[0] ^ first, words[1] ^ seed);
+			}
+			if(i != length) {
+				words[0] = words[1] = 0;
+				memcpy(words, data + i, length - i);
+				seed = mix(words[0] ^ first, words[1] ^ seed);
+			}
+			return mix(seed ^ length, second);
+		}
+
+		// hashes both ends of a file, or all of it. a file that is not as
+		// long as it was is an error, it changed while it was looked at
+		static int hash_file(const std::string &path, unsigned long size, bool sample, std::uint64_t &result,
+				std::vector<char> &buffer) {
+
+			std::unique_ptr<std::istream> file = vfs::current().open_file(path);
+			if(file == nullptr) {
+				return errno;
+			}
+
+			result = size;
+			auto read = [&](unsigned long length) {
+				file->read(buffer.data(), length);
+				if(static_cast<unsigned long>(file->gcount()) != length) {
+					return false;
+				}
+				stats::bytes_read += length;
+				result = hash(buffer.data(), length, result);
+				return true;
+			};
+
+			if(sample && size > 2 * dupes_sample_size) {
+				if(!read(dupes_sample_size) || !file->seekg(size - dupes_sample_size) || !read(dupes_sample_size)) {
+					return ESTALE;
+				}
+				return 0;
+			}
+
+			for(unsigned long left = size; left != 0;) {
+				unsigned long length = std::min<unsigned long>(left, buffer.size());
+				if(!read(length)) {
+					return ESTALE;
+				}
+				left -= length;
+			}
+			return 0;
+		}
+
+		static void hash_all(const std::string &root, std::vector<candidate*> &files, bool sample) {
+			std::atomic<std::size_t> next(0);
+			auto work = [&]() {
+				std::vector<char> buffer(dupes_buffer_size);
+				std::size_t i;
+				while((i = next++) < files.size()) {
+					files[i]->error = hash_file(full_path(root, files[i]->path), files[i]->size, sample, files[i]->hash, buffer);
+				}
+			};
+
+			int cores = dupes_threads != 0 ? dupes_threads : std::max(1u, std::thread::hardware_concurrency());
+			int thread_count = std::min<std::size_t>(cores, files.size());
+
+			std::vector<std::thread> threads;
+			for(int i = 1; i < thread_count; i++) {
+				threads.emplace_back(work);
+			}
+			work();
+			for(auto &thread : threads) {
+				thread.join();
+			}
+		}
+
+		// runs of files with the same size and hash, errors are left out
+		static std::vector<std::vector<candidate*>> same(std::vector<candidate*> files, bool by_hash, unsigned long &errors) {
+			auto key = [by_hash](const candidate *file) {
+				return std::make_pair(file->size, by_hash ? file->hash : 0);
+			};
+
+			files.erase(std::remove_if(files.begin(), files.end(), [&errors](const candidate *file) {
+				errors += file->error != 0;
+				return file->error != 0;
+			}), files.end());
+			std::sort(files.begin(), files.end(), [&key](const candidate *a, const candidate *b) {
+				return key(a) < key(b);
+			});
+
+			std::vector<std::vector<candidate*>> runs;
+			for(std::size_t i = 0, end; i < files.size(); i = end) {
+				for(end = i + 1; end < files.size() && key(files[end]) == key(files[i]); end++);
+				if(end - i > 1) {
+					runs.emplace_back(files.begin() + i, files.begin() + end);
+				}
+			}
+			return runs;
+		}
+
+		static void walk(const std::string &root, const std::string &relative, std::vector<candidate> &files,
+				std::set<std::pair<dev_t, ino_t>> &seen, unsigned long &errors) {
+
+			std::unique_ptr<vfs_directory> directory = vfs::current().open_directory(full_path(root, relative));
+			if(directory->error() != 0) {
+				errors++;
+				return;
+			}
+
+			std::vector<std::string> names;
+			std::string_view name;
+			unsigned char type;
+			ino_t inode;
+			while(directory->next(name, type, inode)) {
+				if(show_hidden || name[0] != '.') {
+					names.emplace_back(name);
+				}
+			}
+			directory->done_reading();
+
+			std::vector<std::string> directories;
+			std::vector<const char*> batch;
+			std::vector<struct statx> results;
+			std::vector<int> stat_errors;
+
+			for(std::size_t first = 0; first < names.size(); first += stat_batch_size) {
+				std::size_t count = std::min<std::size_t>(stat_batch_size, names.size() - first);
+				batch.clear();
+				for(std::size_t i = first; i < first + count; i++) {
+					batch.push_back(names[i].c_str());
+				}
+				directory->stat(batch, AT_SYMLINK_NOFOLLOW | AT_STATX_DONT_SYNC, STATX_TYPE | STATX_SIZE | STATX_INO,
+					results, stat_errors);
+
+				for(std::size_t i = 0; i < count; i++) {
+					const struct statx &info = results[i];
+					std::string path = relative.empty() ? names[first + i] : relative + "/" + names[first + i];
+
+					if(stat_errors[i] != 0) {
+						errors++;
+					} else if(S_ISDIR(info.stx_mode)) {
+						directories.push_back(std::move(path));
+					} else if(S_ISREG(info.stx_mode) && info.stx_size != 0
+					&& seen.insert({ makedev(info.stx_dev_major, info.stx_dev_minor), info.stx_ino }).second) {
+						files.push_back({ std::move(path), info.stx_ino, info.stx_size, 0, 0 });
+					}
+				}
+			}
+
+			directory.reset();
+			for(const auto &child : directories) {
+				walk(root, child, files, seen, errors);
+			}
+		}
+
+		void show() {
+			group_of.clear();
+			std::shared_ptr<listing> elements = std::make_shared<listing>();
+			elements->hidden = show_hidden;
+
+			for(std::size_t i = 0; i < groups.size(); i++) {
+				std::string size = "#" + std::to_string(i + 1) + " " + commands::format_file_size(groups[i].size, size_precision);
+				for(const auto &file : groups[i].files) {
+					elements->add(file.first, size, file.second);
+					group_of[file.first] = i;
+				}
+			}
+			shown = elements;
+		}
+
+	public:
+
+		duplicate_finder() {
+			fd = eventfd(0, EFD_NONBLOCK | EFD_CLOEXEC);
+		}
+
+		~duplicate_finder() {
+			if(fd != -1) {
+				close(fd);
+			}
+		}
+
+		int get_fd() const {
+			return fd;
+		}
+
+		// the search itself, paths are relative to root. files counts
+		// every file looked at, errors what could not be read
+		static std::vector<duplicate_group> find(const std::string &root, const std::vector<std::string> &paths,
+				unsigned long &files, unsigned long &errors) {
+
+			std::vector<candidate> found;
+			std::set<std::pair<dev_t, ino_t>> seen;
+			errors = 0;
+
+			for(const auto &path : paths) {
+				struct statx info;
+				int error = vfs::current().stat(full_path(root, path), info, false);
+				if(error != 0) {
+					errors++;
+				} else if(S_ISDIR(info.stx_mode)) {
+					walk(root, path, found, seen, errors);
+				} else if(S_ISREG(info.stx_mode) && info.stx_size != 0
+				&& seen.insert({ makedev(info.stx_dev_major, info.stx_dev_minor), info.stx_ino }).second) {
+					found.push_back({ path, info.stx_ino, info.stx_size, 0, 0 });
+				}
+			}
+			files = found.size();
+
+			std::vector<candidate*> sized;
+			for(auto &file : found) {
+				sized.push_back(&file);
+			}
+
+			// sizes, then both ends, then everything of what is left
+			std::vector<candidate*> sampled, whole;
+			for(auto &run : same(sized, false, errors)) {
+				sampled.insert(sampled.end(), run.begin(), run.end());
+			}
+			hash_all(root, sampled, true);
+
+			std::vector<std::vector<candidate*>> runs;
+			for(auto &run : same(sampled, true, errors)) {
+				if(run[0]->size > 2 * dupes_sample_size) {
+					whole.insert(whole.end(), run.begin(), run.end());
+				} else {
+					runs.push_back(std::move(run));
+				}
+			}
+			hash_all(root, whole, false);
+
+			for(auto &run : same(whole, true, errors)) {
+				runs.push_back(std::move(run));
+			}
+
+			std::vector<duplicate_group> result;
+			for(auto &run : runs) {
+				duplicate_group group = { run[0]->size, {} };
+				for(const candidate *file : run) {
+					group.files.emplace_back(file->path, file->inode);
+				}
+				std::sort(group.files.begin(), group.files.end());
+				result.push_back(std::move(group));
+			}
+			std::sort(result.begin(), result.end(), [](const duplicate_group &a, const duplicate_group &b) {
+				return a.size * (a.files.size() - 1) > b.size * (b.files.size() - 1);
+			});
+			return result;
+		}
+
+		// looks below paths of root off the ui thread, false if a search is running
+		bool start(const std::string &root_, const std::vector<std::string> &paths) {
+			if(running) {
+				return false;
+			}
+			running = true;
+
+			std::shared_ptr<finished_search> done = finished;
+			int event = fd;
+
+			std::thread([done, root_, paths, event]() {
+				std::unique_ptr<result> search = std::make_unique<result>();
+				search->root = root_;
+				search->groups = find(root_, paths, search->files, search->errors);
+
+				{
+					std::lock_guard<std::mutex> lock(done->mutex);
+					done->search = std::move(search);
+				}
+				unsigned long long one = 1;
+				if(::write(event, &one, sizeof(one)) < 0) {
+					return;
+				}
+			}).detach();
+			return true;
+		}
+
+		bool is_running() const {
+			return running;
+		}
+
+		// takes over a finished search, true if there is one
+		bool collect() {
+			unsigned long long count;
+			stats::syscalls++;
+			if(fd == -1 || ::read(fd, &count, sizeof(count)) != sizeof(count)) {
+				return false;
+			}
+
+			std::unique_ptr<result> search;
+			{
+				std::lock_guard<std::mutex> lock(finished->mutex);
+				search = std::move(finished->search);
+			}
+			if(search == nullptr) {
+				return false;
+			}
+			running = false;
+
+			unsigned long copies = 0;
+			double wasted = 0;
+			for(const auto &group : search->groups) {
+				copies += group.files.size() - 1;
+				wasted += static_cast<double>(group.size) * (group.files.size() - 1);
+			}
+
+			summary = std::to_string(search->groups.size()) + " groups of duplicates in " + search->root + ", "
+				+ std::to_string(copies) + " copies of " + std::to_string(search->files) + " files waste "
+				+ commands::format_file_size(wasted, size_precision)
+				+ (search->errors != 0 ? ", " + std::to_string(search->errors) + " unreadable" : "");
+
+			root = search->root;
+			groups = std::move(search->groups);
+			show();
+			return true;
+		}
+
+		const std::string &describe() const {
+			return summary;
+		}
+
+		// the groups as a listing if they belong to directory, nullptr otherwise
+		std::shared_ptr<const listing> view(const std::string &directory) const {
+			return directory == root ? shown : nullptr;
+		}
+
+		void close_view() {
+			root.clear();
+			groups.clear();
+			group_of.clear();
+			shown = nullptr;
+		}
+
+		// the files of the group of a shown path, empty if it is in none
+		std::vector<std::string> group(const std::string &path) const {
+			std::vector<std::string> result;
+			auto found = group_of.find(path);
+			if(found != group_of.end()) {
+				for(const auto &file : groups[found->second].files) {
+					result.push_back(file.first);
+				}
+			}
+			return result;
+		}
+
+		// shown paths are gone or no copies anymore, groups of one go too
+		void forget(const std::vector<std::string> &paths) {
+			bool changed = false;
+			for(const auto &path : paths) {
+				auto found = group_of.find(path);
+				if(found == group_of.end()) {
+					continue;
+				}
+
+				std::vector<std::pair<std::string, ino_t>> &files = groups[found->second].files;
+				files.erase(std::remove_if(files.begin(), files.end(), [&path](const std::pair<std::string, ino_t> &file) {
+					return file.first == path;
+				}), files.end());
+				group_of.erase(found);
+				changed = true;
+			}
+
+			if(changed) {
+				groups.erase(std::remove_if(groups.begin(), groups.end(), [](const duplicate_group &group) {
+					return group.files.size() < 2;
+				}), groups.end());
+				show();
+			}
+		}
+};
+
+# endif
@@ -0,0 +1,331 @@
+# ifndef FRECENCY_H
+# define FRECENCY_H
+
+struct frecency_entry {
+	double rank;
+	long last;
+};
+
+// visited directories kept on disk as an append only log of
+// "rank<tab>time<tab>path" lines. visits only append, so startup never
+// reads the file. it is read on the first jump and rewritten compacted
+// through a rename when it has grown too many duplicate lines. other
+// running odysseys share the log: appends hold a shared flock and
+// compaction an exclusive one, and whoever finds the file swapped under
+// its descriptor opens it again
+class frecency_database {
+	private:
+
+		std::string filename;
+		int fd = -1;
+
+		bool loaded = false;
+		int lines = 0;
+
+		std::unordered_map<std::string, frecency_entry> entries;
+
+		// found missing by jump, left out when the log is compacted
+		std::unordered_set<std::string> gone;
+
+		static std::string default_filename() {
+			const char *data = getenv("XDG_DATA_HOME");
+			const char *home = getenv("HOME");
+
+			if(data != nullptr && data[0] != '\0') {
+				return std::string(data) + "/odyssey/frecency";
+			} else if(home != nullptr) {
+				return std::string(home) + "/.local/share/odyssey/frecency";
+			}
+			return "";
+		}
+
+		bool open_log() {
+			if(fd != -1) {
+				return true;
+			}
+
+			if(filename == "") {
+				filename = default_filename();
+				if(filename == "") {
+					return false;
+				}
+
+				boost::system::error_code error;
+				boost::filesystem::create_directories(boost::filesystem::path(filename).parent_path(), error);
+			}
+
+			fd = ::open(filename.c_str(), O_WRONLY | O_APPEND | O_CREAT | O_CLOEXEC, 0600);
+			return fd != -1;
+		}
+
+		// flocks the log, first opening it again if it was renamed over
+		// since it was opened. false if it cannot be opened or locked
+		bool lock_log(int operation) {
+			while(open_log()) {
+				struct stat opened, named;
+				if(flock(fd, operation) != 0) {
+					return false;
+				} else if(fstat(fd, &opened) != 0) {
+					flock(fd, LOCK_UN);
+					return false;
+				} else if(::stat(filename.c_str(), &named) == 0
+				&& opened.st_dev == named.st_dev && opened.st_ino == named.st_ino) {
+					return true;
+				}
+
+				// closing drops the lock
+				close(fd);
+				fd = -1;
+			}
+			return false;
+		}
+
+		// sums up every line of the log, a torn last line is ignored
+		void read_log() {
+			entries.clear();
+			lines = 0;
+
+			int read_fd = ::open(filename.c_str(), O_RDONLY | O_CLOEXEC);
+			struct stat info;
+			if(read_fd == -1 || fstat(read_fd, &info) != 0 || info.st_size == 0) {
+				if(read_fd != -1) {
+					close(read_fd);
+				}
+				return;
+			}
+
+			char *data = static_cast<char*>(mmap(nullptr, info.st_size, PROT_READ, MAP_PRIVATE, read_fd, 0));
+			close(read_fd);
+
+			if(data == MAP_FAILED) {
+				return;
+			}
+
+			char *end = data + info.st_size;
+			for(char *line = data; line < end;) {
+				char *newline = static_cast<char*>(memchr(line, '\n', end - line));
+				if(newline == nullptr) {
+					break;
+				}
+
+				char *first = static_cast<char*>(memchr(line, '\t', newline - line));
+				char *second = first ? static_cast<char*>(memchr(first + 1, '\t', newline - first - 1)) : nullptr;
+
+				if(second != nullptr) {
+					frecency_entry &entry = entries[std::string(second + 1, newline)];
+					entry.rank += strtod(line, nullptr);
+					entry.last = std::max(entry.last, strtol(first + 1, nullptr, 10));
+					lines++;
+				}
+
+				line = newline + 1;
+			}
+
+			munmap(data, info.st_size);
+		}
+
+		void load() {
+			loaded = true;
+
+			if(!open_log()) {
+				return;
+			}
+
+			read_log();
+			if(lines > entries.size() * 2 + 64) {
+				compact();
+			}
+		}
+
+		// writes one line per directory to a new file and swaps it in. the
+		// log is read again under the lock, others may have appended since
+		void compact() {
+			if(!lock_log(LOCK_EX)) {
+				return;
+			}
+
+			read_log();
+			for(const auto &path : gone) {
+				entries.erase(path);
+			}
+
+			double sum = 0;
+			for(const auto &entry : entries) {
+				sum += entry.second.rank;
+			}
+
+			// old entries fade out once the ranks add up too much
+			if(sum > max_frecency_rank) {
+				for(auto iterator = entries.begin(); iterator != entries.end();) {
+					iterator->second.rank *= 0.9;
+					if(iterator->second.rank < 1) {
+						iterator = entries.erase(iterator);
+					} else {
+						iterator++;
+					}
+				}
+			}
+
+			std::string temporary = filename + ".tmp";
+			FILE *stream = fopen(temporary.c_str(), "w");
+			if(stream == nullptr) {
+				flock(fd, LOCK_UN);
+				return;
+			}
+
+			for(const auto &entry : entries) {
+				fprintf(stream, "%g\t%ld\t%s\n", entry.second.rank, entry.second.last, entry.first.c_str());
+			}
+
+			bool failed = fflush(stream) != 0 || fsync(fileno(stream)) != 0;
+			failed = fclose(stream) != 0 || failed;
+
+			if(failed || rename(temporary.c_str(), filename.c_str()) != 0) {
+				unlink(temporary.c_str());
+				flock(fd, LOCK_UN);
+				return;
+			}
+
+			// waiting appenders find the new file once the lock is gone
+			close(fd);
+			fd = -1;
+			open_log();
+			lines = entries.size();
+		}
+
+		// ranks recent visits higher, like z does
+		static double score(const frecency_entry &entry, long now) {
+			long age = now - entry.last;
+			if(age < 3600) {
+				return entry.rank * 4;
+			} else if(age < 86400) {
+				return entry.rank * 2;
+			} else if(age < 604800) {
+				return entry.rank / 2;
+			}
+			return entry.rank / 4;
+		}
+
+		static bool equal_ignore_case(char a, char b) {
+			return tolower(static_cast<unsigned char>(a)) == tolower(static_cast<unsigned char>(b));
+		}
+
+		// every term appears in order, as a substring or as a subsequence.
+		// as a substring the last term has to be in the last component
+		static bool matches(const std::string &path, const std::vector<std::string> &terms, bool fuzzy) {
+			std::string::const_iterator position = path.begin();
+
+			for(int i = 0; i < terms.size(); i++) {
+				const std::string &term = terms[i];
+
+				if(fuzzy) {
+					for(char character : term) {
+						position = std::find_if(position, path.end(), [character](char other) {
+							return equal_ignore_case(character, other);
+						});
+						if(position == path.end()) {
+							return false;
+						}
+						position++;
+					}
+				} else if(i == terms.size() - 1) {
+					position = std::find_end(position, path.end(), term.begin(), term.end(), equal_ignore_case);
+					return position != path.end()
+						&& std::find(position + term.length(), path.end(), '/') == path.end();
+				} else {
+					position = std::search(position, path.end(), term.begin(), term.end(), equal_ignore_case);
+					if(position == path.end()) {
+						return false;
+					}
+					position += term.length();
+				}
+			}
+
+			return true;
+		}
+
+	public:
+
+		~frecency_database() {
+			if(fd != -1) {
+				close(fd);
+			}
+		}
+
+		void visit(std::string directory) {
+			if(directory.find_first_of("\t\n") != std::string::npos || !lock_log(LOCK_SH)) {
+				return;
+			}
+
+			long now = time(nullptr);
+			std::string line = "1\t" + std::to_string(now) + "\t" + directory + "\n";
+
+			// one write so a line is either all there or torn at the end
+			bool written = write(fd, line.c_str(), line.length()) == line.length();
+			flock(fd, LOCK_UN);
+			if(!written) {
+				return;
+			}
+			lines++;
+			gone.erase(directory);
+
+			if(loaded) {
+				frecency_entry &entry = entries[directory];
+				entry.rank += 1;
+				entry.last = now;
+
+				if(lines > entries.size() * 2 + 64) {
+					compact();
+				}
+			}
+		}
+
+		// best ranked existing directory matching the terms, empty if none
+		std::string jump(std::vector<std::string> terms) {
+			if(!loaded) {
+				load();
+			}
+
+			long now = time(nullptr);
+
+			for(bool fuzzy : { false, true }) {
+				// on a mount that does not answer, left alone for this jump
+				std::unordered_set<const std::string*> unanswered;
+
+				while(true) {
+					const std::string *best = nullptr;
+					double best_score = 0;
+
+					for(const auto &entry : entries) {
+						double entry_score = score(entry.second, now);
+						if(entry_score > best_score && unanswered.count(&entry.first) == 0
+						&& matches(entry.first, terms, fuzzy)) {
+							best = &entry.first;
+							best_score = entry_score;
+						}
+					}
+
+					if(best == nullptr) {
+						break;
+					}
+
+					// gone since it was visited? forget it and look again
+					struct stat info;
+					if(fs_guard::stat(*best, info)) {
+						if(S_ISDIR(info.st_mode)) {
+							return *best;
+						}
+					} else if(errno == ETIMEDOUT) {
+						unanswered.insert(best);
+						continue;
+					}
+					gone.insert(*best);
+					entries.erase(*best);
+				}
+			}
+
+			return "";
+		}
+};
+
+# endif
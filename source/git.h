@@ -0,0 +1,805 @@
+# ifndef GIT_H
+# define GIT_H
+
+struct git_entry {
+	unsigned int name_offset;
+	unsigned int name_length;
+
+	unsigned int ctime_sec, ctime_nsec;
+	unsigned int mtime_sec, mtime_nsec;
+	unsigned int inode, mode, size;
+
+	unsigned short flags;
+	unsigned short extended_flags;
+};
+
+// the entries of a .git/index, versions 2 to 4. names are kept in one
+// buffer in the order of the file, which git sorts by name
+class git_index {
+	private:
+
+		std::vector<git_entry> entries;
+		std::string names;
+
+		static unsigned int word(const unsigned char *data) {
+			return static_cast<unsigned int>(data[0]) << 24 | data[1] << 16 | data[2] << 8 | data[3];
+		}
+
+		static unsigned short half(const unsigned char *data) {
+			return data[0] << 8 | data[1];
+		}
+
+		// the offset encoding of index version 4
+		static bool varint(const unsigned char *&data, const unsigned char *end, std::size_t &value) {
+			if(data >= end) {
+				return false;
+			}
+
+			unsigned char byte = *data++;
+			value = byte & 0x7f;
+			while(byte & 0x80) {
+				if(data >= end) {
+					return false;
+				}
+				byte = *data++;
+				value = ((value + 1) << 7) | (byte & 0x7f);
+			}
+			return true;
+		}
+
+		bool parse(const unsigned char *data, std::size_t length, int hash_size) {
+			if(length < 12 || memcmp(data, "DIRC", 4) != 0) {
+				return false;
+			}
+
+			unsigned int version = word(data + 4);
+			unsigned int count = word(data + 8);
+			if(version < 2 || version > 4) {
+				return false;
+			}
+
+			entries.reserve(count);
+			const unsigned char *position = data + 12;
+			const unsigned char *end = data + length;
+			std::string previous;
+
+			for(unsigned int i = 0; i < count; i++) {
+				const unsigned char *start = position;
+				std::size_t fixed = 40 + hash_size + 2;
+				if(position + fixed > end) {
+					return false;
+				}
+
+				git_entry entry;
+				entry.ctime_sec = word(position);
+				entry.ctime_nsec = word(position + 4);
+				entry.mtime_sec = word(position + 8);
+				entry.mtime_nsec = word(position + 12);
+				entry.inode = word(position + 20);
+				entry.mode = word(position + 24);
+				entry.size = word(position + 36);
+				entry.flags = half(position + 40 + hash_size);
+				entry.extended_flags = 0;
+				position += fixed;
+
+				if(version >= 3 && (entry.flags & 0x4000)) {
+					if(position + 2 > end) {
+						return false;
+					}
+					entry.extended_flags = half(position);
+					position += 2;
+				}
+
+				std::string name;
+				if(version == 4) {
+					// the name is the end of the previous one cut short and a new suffix
+					std::size_t cut;
+					if(!varint(position, end, cut) || cut > previous.length()) {
+						return false;
+					}
+					const unsigned char *terminator = static_cast<const unsigned char*>(memchr(position, 0, end - position));
+					if(terminator == nullptr) {
+						return false;
+					}
+					name.assign(previous, 0, previous.length() - cut);
+					name.append(reinterpret_cast<const char*>(position), terminator - position);
+					position = terminator + 1;
+				} else {
+					const unsigned char *terminator = static_cast<const unsigned char*>(memchr(position, 0, end - position));
+					if(terminator == nullptr) {
+						return false;
+					}
+					name.assign(reinterpret_cast<const char*>(position), terminator - position);
+
+					// entries are padded with 1 to 8 nuls to a multiple of 8
+					position = start + ((terminator - start) + 8) / 8 * 8;
+				}
+
+				entry.name_offset = names.length();
+				entry.name_length = name.length();
+				names += name;
+				entries.push_back(entry);
+				previous.swap(name);
+			}
+
+			return true;
+		}
+
+	public:
+
+		// false if the file cannot be read or is not an index it knows
+		bool load(const std::string &filename, int hash_size) {
+			stats::syscalls++;
+			int fd = ::open(filename.c_str(), O_RDONLY | O_CLOEXEC);
+			if(fd == -1) {
+				return false;
+			}
+
+			struct stat info;
+			if(fstat(fd, &info) != 0 || info.st_size == 0) {
+				close(fd);
+				return false;
+			}
+
+			void *data = mmap(nullptr, info.st_size, PROT_READ, MAP_PRIVATE, fd, 0);
+			close(fd);
+			if(data == MAP_FAILED) {
+				return false;
+			}
+
+			stats::bytes_read += info.st_size;
+			bool parsed = parse(static_cast<const unsigned char*>(data), info.st_size, hash_size);
+			munmap(data, info.st_size);
+			return parsed;
+		}
+
+		std::size_t size() const {
+			return entries.size();
+		}
+
+		const git_entry &operator[](std::size_t index) const {
+			return entries[index];
+		}
+
+		std::string_view name(std::size_t index) const {
+			return std::string_view(names.data() + entries[index].name_offset, entries[index].name_length);
+		}
+
+		// the first entry not sorted before path
+		std::size_t lower_bound(std::string_view path) const {
+			std::size_t low = 0, high = entries.size();
+			while(low < high) {
+				std::size_t middle = (low + high) / 2;
+				if(name(middle) < path) {
+					low = middle + 1;
+				} else {
+					high = middle;
+				}
+			}
+			return low;
+		}
+
+		// the entry of a path, -1 if it is not tracked
+		long find(std::string_view path) const {
+			std::size_t index = lower_bound(path);
+			return index < entries.size() && name(index) == path ? static_cast<long>(index) : -1;
+		}
+
+		// true if anything below the directory is tracked, prefix ends with /
+		bool tracks(std::string_view prefix) const {
+			std::size_t index = lower_bound(prefix);
+			return index < entries.size() && name(index).substr(0, prefix.length()) == prefix;
+		}
+};
+
+struct git_ignore_rule {
+	// directory of the .gitignore relative to the work tree, empty at its root
+	std::string base;
+	std::string pattern;
+	bool negated;
+	bool directory_only;
+	bool anchored;
+};
+
+// one scan of a repository: its index and every directory that has a
+// tracked file below it that changed or is gone
+struct git_snapshot {
+	git_index index;
+	std::unordered_set<std::string> dirty;
+	struct timespec index_mtime;
+};
+
+struct git_repository {
+	std::string root;
+	std::string git_directory;
+	int hash_size = 20;
+
+	std::shared_ptr<const git_snapshot> snapshot;
+
+	// index time of the scan running or last started
+	struct timespec index_mtime = { 0, 0 };
+	bool scanning = false;
+	bool outdated = false;
+	unsigned long scan_start = 0;
+
+	// rules of the .gitignore of each directory read so far, relative to the root
+	std::unordered_map<std::string, std::vector<git_ignore_rule>> ignores;
+};
+
+// status of a row of the listing, as git status shows it
+enum git_state : char {
+	GIT_UNKNOWN = 0,
+	GIT_CLEAN = ' ',
+	GIT_MODIFIED = 'M',
+	GIT_UNTRACKED = '?',
+	GIT_IGNORED = '!',
+	GIT_CONFLICT = 'U',
+};
+
+// git status of the main listing without running git. .git/index is
+// parsed and its stat data compared against statx of the rows drawn, the
+// way git itself decides a file is unchanged without reading it. whether
+// a directory holds changes comes from a scan of every tracked file,
+// which runs on its own thread and is done again once the index or a
+// watched directory changed. it is told of being done through an eventfd
+class git_status {
+	private:
+
+		// scans that finished, handed over from their threads
+		struct finished_scans {
+			std::mutex mutex;
+			std::vector<std::pair<std::string, std::shared_ptr<const git_snapshot>>> scans;
+		};
+
+		std::shared_ptr<finished_scans> finished = std::make_shared<finished_scans>();
+		int fd = -1;
+
+		std::unordered_map<std::string, git_repository> repositories;
+
+		// work tree each directory is in, empty if none
+		std::unordered_map<std::string, std::string> roots;
+
+		// rows of the listing drawn, filled as they are drawn
+		std::shared_ptr<const listing> source;
+		std::shared_ptr<const git_snapshot> source_snapshot;
+		std::vector<git_state> rows;
+
+		// when the index was last looked at, in microseconds
+		unsigned long last_check = 0;
+
+		static std::vector<git_ignore_rule> read_ignore(const std::string &filename, const std::string &base) {
+			std::vector<git_ignore_rule> rules;
+			std::ifstream file(filename);
+			std::string line;
+
+			while(std::getline(file, line)) {
+				while(!line.empty() && (line.back() == ' ' || line.back() == '\r') && (line.length() < 2 || line[line.length() - 2] != '\\')) {
+					line.pop_back();
+				}
+				if(line.empty() || line[0] == '#') {
+					continue;
+				}
+
+				git_ignore_rule rule = { base, line, false, false, false };
+				if(rule.pattern[0] == '!') {
+					rule.negated = true;
+					rule.pattern.erase(0, 1);
+				} else if(rule.pattern[0] == '\\') {
+					rule.pattern.erase(0, 1);
+				}
+
+				if(!rule.pattern.empty() && rule.pattern.back() == '/') {
+					rule.directory_only = true;
+					rule.pattern.pop_back();
+				}
+
+				// a/** ignores what is inside a, close enough to ignoring a
+				if(rule.pattern.length() > 3 && rule.pattern.compare(rule.pattern.length() - 3, 3, "/**") == 0) {
+					rule.pattern.resize(rule.pattern.length() - 3);
+				}
+				while(rule.pattern.compare(0, 3, "**/") == 0) {
+					rule.pattern.erase(0, 3);
+				}
+
+				rule.anchored = rule.pattern.find('/') != std::string::npos;
+				if(!rule.pattern.empty() && rule.pattern[0] == '/') {
+					rule.pattern.erase(0, 1);
+				}
+
+				if(!rule.pattern.empty()) {
+					rules.push_back(rule);
+				}
+			}
+
+			return rules;
+		}
+
+		// the work tree of a directory and its git directory, found by
+		// looking for .git upwards. a .git file points to the git directory
+		static bool discover(const std::string &directory, std::string &root, std::string &git_directory) {
+			std::string path = directory;
+			while(true) {
+				std::string candidate = (path == "/" ? "" : path) + "/.git";
+
+				struct stat info;
+				stats::syscalls++;
+				if(stat(candidate.c_str(), &info) == 0) {
+					root = path;
+					if(S_ISDIR(info.st_mode)) {
+						git_directory = candidate;
+						return true;
+					}
+
+					std::ifstream file(candidate);
+					std::string line;
+					if(std::getline(file, line) && line.compare(0, 8, "gitdir: ") == 0) {
+						git_directory = line.substr(8);
+						if(git_directory[0] != '/') {
+							git_directory = path + "/" + git_directory;
+						}
+						return true;
+					}
+					return false;
+				}
+
+				if(path == "/" || path.empty()) {
+					return false;
+				}
+				path = boost::filesystem::path(path).parent_path().string();
+			}
+		}
+
+		// path of a directory inside the work tree, empty for the root itself
+		static std::string relative(const std::string &root, const std::string &directory) {
+			if(directory.length() <= root.length()) {
+				return "";
+			}
+			return directory.substr(root == "/" ? 1 : root.length() + 1);
+		}
+
+		// where the ignore rules for a directory come from: info/exclude,
+		// kept under "\n", and the .gitignore of it and every directory above
+		static std::vector<std::string> ignore_bases(const std::string &directory) {
+			std::vector<std::string> result = { "\n", "" };
+			for(std::size_t slash = directory.find('/'); !directory.empty(); slash = directory.find('/', slash + 1)) {
+				result.push_back(directory.substr(0, slash));
+				if(slash == std::string::npos) {
+					break;
+				}
+			}
+			return result;
+		}
+
+		static bool same_time(struct timespec a, struct timespec b) {
+			return a.tv_sec == b.tv_sec && a.tv_nsec == b.tv_nsec;
+		}
+
+		// what git compares before it would read a file, its default checkStat
+		static bool unchanged(const git_entry &entry, const struct statx &info) {
+			return entry.mtime_sec == static_cast<unsigned int>(info.stx_mtime.tv_sec)
+				&& entry.mtime_nsec == info.stx_mtime.tv_nsec
+				&& entry.ctime_sec == static_cast<unsigned int>(info.stx_ctime.tv_sec)
+				&& entry.ctime_nsec == info.stx_ctime.tv_nsec
+				&& entry.inode == static_cast<unsigned int>(info.stx_ino)
+				&& entry.size == static_cast<unsigned int>(info.stx_size)
+				&& (entry.mode & S_IFMT) == (info.stx_mode & S_IFMT);
+		}
+
+		static const int scan_mask = STATX_TYPE | STATX_MODE | STATX_INO | STATX_SIZE | STATX_MTIME | STATX_CTIME;
+
+		// loads the index and stats every tracked file, a directory at a time
+		static std::shared_ptr<const git_snapshot> scan(std::string root, std::string git_directory, int hash_size) {
+			std::shared_ptr<git_snapshot> snapshot = std::make_shared<git_snapshot>();
+
+			struct stat info;
+			std::string filename = git_directory + "/index";
+			stats::syscalls++;
+			if(stat(filename.c_str(), &info) != 0 || !snapshot->index.load(filename, hash_size)) {
+				snapshot->index_mtime = { 0, 0 };
+				return snapshot;
+			}
+			snapshot->index_mtime = info.st_mtim;
+
+			const git_index &index = snapshot->index;
+			std::vector<const char*> names;
+			std::vector<std::size_t> members;
+			std::vector<std::string> storage;
+			std::vector<struct statx> results;
+			std::vector<int> errors;
+
+			auto mark = [&](std::string_view path) {
+				// every directory above a change holds it
+				for(std::size_t slash = path.find('/'); slash != std::string_view::npos; slash = path.find('/', slash + 1)) {
+					snapshot->dirty.emplace(path.substr(0, slash));
+				}
+			};
+
+			// entries of one directory follow each other unless a deeper one is in between
+			for(std::size_t first = 0; first < index.size();) {
+				std::string_view path = index.name(first);
+				std::size_t slash = path.rfind('/');
+				std::string_view parent = slash == std::string_view::npos ? std::string_view() : path.substr(0, slash);
+
+				names.clear();
+				members.clear();
+				storage.clear();
+
+				std::size_t last = first;
+				for(; last < index.size() && names.size() < stat_batch_size; last++) {
+					std::string_view name = index.name(last);
+					std::size_t end = name.rfind('/');
+					std::string_view directory = end == std::string_view::npos ? std::string_view() : name.substr(0, end);
+					if(directory != parent) {
+						break;
+					}
+
+					// conflicts count as changes, files left out of the work tree do not
+					if(((index[last].flags >> 12) & 3) != 0) {
+						mark(name);
+					} else if(!(index[last].extended_flags & 0x4000)) {
+						storage.emplace_back(parent.empty() ? name : name.substr(parent.length() + 1));
+						members.push_back(last);
+					}
+				}
+
+				for(const auto &name : storage) {
+					names.push_back(name.c_str());
+				}
+
+				std::string directory = root + (parent.empty() ? "" : "/" + std::string(parent));
+				stats::syscalls++;
+				int directory_fd = ::open(directory.c_str(), O_RDONLY | O_DIRECTORY | O_CLOEXEC);
+
+				if(directory_fd == -1) {
+					for(std::size_t member : members) {
+						mark(index.name(member));
+					}
+				} else if(!names.empty()) {
+					stat_batch::run(directory_fd, names, AT_SYMLINK_NOFOLLOW | AT_STATX_DONT_SYNC, scan_mask, results, errors);
+					for(std::size_t i = 0; i < members.size(); i++) {
+						if(errors[i] != 0 || !unchanged(index[members[i]], results[i])) {
+							mark(index.name(members[i]));
+						}
+					}
+				}
+
+				if(directory_fd != -1) {
+					close(directory_fd);
+				}
+				first = last;
+			}
+
+			return snapshot;
+		}
+
+		void start_scan(git_repository &repository) {
+			repository.scanning = true;
+			repository.outdated = false;
+			repository.scan_start = stats::now();
+
+			std::shared_ptr<finished_scans> done = finished;
+			std::string root = repository.root;
+			std::string git_directory = repository.git_directory;
+			int hash_size = repository.hash_size;
+			int event = fd;
+
+			std::thread([done, root, git_directory, hash_size, event]() {
+				std::shared_ptr<const git_snapshot> snapshot = scan(root, git_directory, hash_size);
+				{
+					std::lock_guard<std::mutex> lock(done->mutex);
+					done->scans.push_back({ root, snapshot });
+				}
+				unsigned long long one = 1;
+				if(::write(event, &one, sizeof(one)) < 0) {
+					return;
+				}
+			}).detach();
+		}
+
+		// true if the rules of the repository ignore a path below its root
+		static bool ignored(const git_repository &repository, const std::string &path, bool directory) {
+			bool result = false;
+
+			auto check = [&](const std::vector<git_ignore_rule> &rules, const std::string &name) {
+				for(const auto &rule : rules) {
+					if(rule.directory_only && !directory) {
+						continue;
+					}
+					if(!rule.base.empty() && path.compare(0, rule.base.length() + 1, rule.base + "/") != 0) {
+						continue;
+					}
+
+					std::string relative = rule.base.empty() ? path : path.substr(rule.base.length() + 1);
+					bool match = rule.anchored ? fnmatch(rule.pattern.c_str(), relative.c_str(), FNM_PATHNAME) == 0
+						: fnmatch(rule.pattern.c_str(), name.c_str(), 0) == 0;
+					if(match) {
+						result = !rule.negated;
+					}
+				}
+			};
+
+			std::string name = path.substr(path.rfind('/') + 1);
+
+			// info/exclude first, then every .gitignore from the root down
+			auto exclude = repository.ignores.find("\n");
+			if(exclude != repository.ignores.end()) {
+				check(exclude->second, name);
+			}
+
+			std::size_t slash = 0;
+			while(true) {
+				std::string base = slash == 0 ? "" : path.substr(0, slash);
+				auto rules = repository.ignores.find(base);
+				if(rules != repository.ignores.end()) {
+					check(rules->second, name);
+				}
+
+				slash = path.find('/', slash == 0 ? 0 : slash + 1);
+				if(slash == std::string::npos) {
+					break;
+				}
+			}
+
+			return result;
+		}
+
+	public:
+
+		git_status() {
+			fd = eventfd(0, EFD_NONBLOCK | EFD_CLOEXEC);
+		}
+
+		~git_status() {
+			if(fd != -1) {
+				close(fd);
+			}
+		}
+
+		int get_fd() const {
+			return fd;
+		}
+
+		// takes scans that finished, true if one has to be drawn
+		bool collect() {
+			unsigned long long count;
+			stats::syscalls++;
+			if(fd == -1 || ::read(fd, &count, sizeof(count)) != sizeof(count)) {
+				return false;
+			}
+
+			std::vector<std::pair<std::string, std::shared_ptr<const git_snapshot>>> scans;
+			{
+				std::lock_guard<std::mutex> lock(finished->mutex);
+				scans.swap(finished->scans);
+			}
+
+			for(auto &scan : scans) {
+				auto repository = repositories.find(scan.first);
+				if(repository != repositories.end()) {
+					repository->second.snapshot = scan.second;
+					repository->second.scanning = false;
+
+					// .gitignore files may have changed with everything else
+					repository->second.ignores.clear();
+				}
+			}
+			return !scans.empty();
+		}
+
+		// discovers the repository of a directory and scans it right away,
+		// nullptr outside of one
+		static std::shared_ptr<const git_snapshot> scan_now(const std::string &directory) {
+			std::string root, git_directory;
+			if(!discover(directory, root, git_directory)) {
+				return nullptr;
+			}
+			return scan(root, git_directory, 20);
+		}
+
+		// true once the index is due to be looked at again
+		bool due() const {
+			return !repositories.empty() && stats::now() - last_check >= git_check_interval * 1000UL;
+		}
+
+		// files changed somewhere, repositories are scanned again once the
+		// last scan is old enough
+		void changed() {
+			for(auto &repository : repositories) {
+				repository.second.outdated = true;
+			}
+		}
+
+		// fills the rows of the listing from first up to count rows after it
+		void prepare(std::shared_ptr<const listing> elements, std::string directory, int first, int count) {
+			auto known = roots.find(directory);
+
+			// looked up, stat'ed and read off the ui thread, the mount may hang
+			struct gathered {
+				bool discovered = false;
+				std::string root, git_directory;
+				int hash_size = 20;
+				struct timespec index_mtime = { 0, 0 };
+
+				std::vector<std::pair<std::string, std::vector<git_ignore_rule>>> ignores;
+
+				std::vector<std::string> names;
+				std::vector<struct statx> results;
+				std::vector<int> errors;
+			};
+
+			std::shared_ptr<gathered> result = std::make_shared<gathered>();
+			bool look_up = known == roots.end();
+			git_repository *repository = nullptr;
+
+			if(!look_up) {
+				if(known->second.empty()) {
+					rows.clear();
+					source = nullptr;
+					return;
+				}
+				repository = &repositories[known->second];
+				result->root = repository->root;
+				result->git_directory = repository->git_directory;
+			}
+
+			if(elements != source || (repository != nullptr && repository->snapshot != source_snapshot)) {
+				source = elements;
+				source_snapshot = repository != nullptr ? repository->snapshot : nullptr;
+				rows.assign(elements->size(), GIT_UNKNOWN);
+			}
+
+			int last = std::min(first + count, static_cast<int>(rows.size()));
+			std::vector<int> indices;
+			for(int i = first; i < last; i++) {
+				if(rows[i] == GIT_UNKNOWN) {
+					result->names.emplace_back(elements->name(i));
+					if(result->names.back().back() == '/') {
+						result->names.back().pop_back();
+					}
+					indices.push_back(i);
+				}
+			}
+
+			if(!look_up && indices.empty() && stats::now() - last_check < git_check_interval * 1000UL) {
+				return;
+			}
+			last_check = stats::now();
+
+			// .gitignore files of the directories down to this one not read yet
+			std::vector<std::string> bases;
+			if(repository != nullptr) {
+				for(auto &base : ignore_bases(relative(repository->root, directory))) {
+					if(repository->ignores.count(base) == 0) {
+						bases.push_back(base);
+					}
+				}
+			}
+
+			bool answered = fs_guard::run(directory, [result, directory, look_up, bases]() {
+				if(look_up) {
+					result->discovered = discover(directory, result->root, result->git_directory);
+					if(!result->discovered) {
+						return;
+					}
+
+					std::ifstream config(result->git_directory + "/config");
+					std::string line;
+					while(std::getline(config, line)) {
+						boost::algorithm::to_lower(line);
+						if(line.find("objectformat") != std::string::npos && line.find("sha256") != std::string::npos) {
+							result->hash_size = 32;
+						}
+					}
+				}
+
+				struct stat info;
+				stats::syscalls++;
+				if(stat((result->git_directory + "/index").c_str(), &info) == 0) {
+					result->index_mtime = info.st_mtim;
+				}
+
+				std::vector<std::string> wanted = look_up ? ignore_bases(relative(result->root, directory)) : bases;
+				for(const auto &base : wanted) {
+					std::string filename = base == "\n" ? result->git_directory + "/info/exclude"
+						: result->root + (base.empty() ? "" : "/" + base) + "/.gitignore";
+					result->ignores.push_back({ base, read_ignore(filename, base == "\n" ? "" : base) });
+				}
+
+				if(result->names.empty()) {
+					return;
+				}
+
+				stats::syscalls++;
+				int directory_fd = ::open(directory.c_str(), O_RDONLY | O_DIRECTORY | O_CLOEXEC);
+				if(directory_fd == -1) {
+					result->errors.assign(result->names.size(), errno);
+					return;
+				}
+
+				std::vector<const char*> names;
+				for(const auto &name : result->names) {
+					names.push_back(name.c_str());
+				}
+				stat_batch::run(directory_fd, names, AT_SYMLINK_NOFOLLOW | AT_STATX_DONT_SYNC, scan_mask,
+						result->results, result->errors);
+				close(directory_fd);
+			});
+
+			if(!answered) {
+				return;
+			}
+
+			if(look_up) {
+				roots[directory] = result->discovered ? result->root : "";
+				if(!result->discovered) {
+					rows.clear();
+					source = nullptr;
+					return;
+				}
+
+				repository = &repositories[result->root];
+				if(repository->root.empty()) {
+					repository->root = result->root;
+					repository->git_directory = result->git_directory;
+					repository->hash_size = result->hash_size;
+				}
+			}
+
+			for(auto &rules : result->ignores) {
+				repository->ignores[rules.first] = std::move(rules.second);
+			}
+
+			// a new index or changes seen since the last scan
+			if(!repository->scanning && (!same_time(result->index_mtime, repository->index_mtime)
+			|| (repository->outdated && stats::now() - repository->scan_start >= git_check_interval * 1000UL))) {
+
+				repository->index_mtime = result->index_mtime;
+				start_scan(*repository);
+			}
+
+			const git_snapshot *snapshot = repository->snapshot.get();
+			if(snapshot == nullptr) {
+				return;
+			}
+
+			std::string below = relative(repository->root, directory);
+			bool inside_ignored = !below.empty() && ignored(*repository, below, true);
+
+			for(std::size_t i = 0; i < indices.size(); i++) {
+				const std::string &name = result->names[i];
+				std::string path = below.empty() ? name : below + "/" + name;
+				bool directory_row = elements->name(indices[i]).back() == '/';
+				git_state state = GIT_CLEAN;
+
+				if(path == ".git") {
+					state = GIT_CLEAN;
+				} else if(directory_row) {
+					if(snapshot->dirty.count(path) != 0) {
+						state = GIT_MODIFIED;
+					} else if(!snapshot->index.tracks(path + "/")) {
+						state = inside_ignored || ignored(*repository, path, true) ? GIT_IGNORED : GIT_UNTRACKED;
+					}
+				} else {
+					long entry = snapshot->index.find(path);
+					if(entry == -1) {
+						state = inside_ignored || ignored(*repository, path, false) ? GIT_IGNORED : GIT_UNTRACKED;
+					} else if(((snapshot->index[entry].flags >> 12) & 3) != 0) {
+						state = GIT_CONFLICT;
+					} else if(!(snapshot->index[entry].extended_flags & 0x4000)
+					&& (result->errors[i] != 0 || !unchanged(snapshot->index[entry], result->results[i]))) {
+
+						state = GIT_MODIFIED;
+					}
+				}
+
+				rows[indices[i]] = state;
+			}
+		}
+
+		// GIT_UNKNOWN until the row was prepared or outside a repository
+		git_state state(int index) const {
+			return index >= 0 && index < rows.size() ? rows[index] : GIT_UNKNOWN;
+		}
+};
+
+# endif
@@ -0,0 +1,279 @@
+# ifndef GUARD_H
+# define GUARD_H
+
+struct guard_job {
+	std::function<void()> work;
+	std::string mount;
+
+	std::mutex mutex;
+	std::condition_variable finished;
+	bool done = false;
+
+	// nobody waits for it anymore, its end is announced through recovered
+	bool abandoned = false;
+};
+
+struct guard_worker {
+	std::mutex mutex;
+	std::condition_variable wake;
+	std::shared_ptr<guard_job> job;
+
+	// replaced while stuck, leaves after its job
+	bool retired = false;
+};
+
+// filesystem calls for drawing run on a worker thread and are waited for
+// only until a deadline. a call that misses it leaves its worker stuck in
+// the kernel, a new one takes over, and the mount is reported hung without
+// asking it again until that call comes back. work that may take long on
+// a healthy disk runs on a thread of its own instead, only a stat missing
+// the deadline after it marks the mount hung. work must only touch what
+// it owns, it can outlive the caller
+class fs_guard {
+	private:
+
+		struct state {
+			std::mutex mutex;
+			std::unordered_set<std::string> hung;
+			bool recovered = false;
+			std::shared_ptr<guard_worker> worker;
+			mount_table mounts;
+
+			// written when recovered is set, the idle loop polls it
+			int fd = eventfd(0, EFD_NONBLOCK | EFD_CLOEXEC);
+		};
+
+		static state &shared() {
+			static state instance;
+			return instance;
+		}
+
+		static void serve(std::shared_ptr<guard_worker> worker) {
+			while(true) {
+				std::shared_ptr<guard_job> job;
+				{
+					std::unique_lock<std::mutex> lock(worker->mutex);
+					worker->wake.wait(lock, [&]() { return worker->job != nullptr || worker->retired; });
+					if(worker->job == nullptr) {
+						return;
+					}
+					job = worker->job;
+				}
+
+				job->work();
+
+				bool abandoned;
+				{
+					std::lock_guard<std::mutex> lock(job->mutex);
+					job->done = true;
+					abandoned = job->abandoned;
+				}
+				job->finished.notify_one();
+
+				// the mount answered after all
+				if(abandoned) {
+					announce(job->mount);
+				}
+
+				// the next job may already be waiting
+				std::lock_guard<std::mutex> lock(worker->mutex);
+				if(worker->job == job) {
+					worker->job = nullptr;
+				}
+				if(worker->retired) {
+					return;
+				}
+			}
+		}
+
+		static void announce(const std::string &mount) {
+			{
+				std::lock_guard<std::mutex> lock(shared().mutex);
+				shared().hung.erase(mount);
+				shared().recovered = true;
+			}
+			unsigned long long one = 1;
+			if(::write(shared().fd, &one, sizeof(one)) < 0) {
+				return;
+			}
+		}
+
+		static std::chrono::milliseconds deadline(const mount_entry &mount) {
+			return std::chrono::milliseconds(mount.remote ? remote_deadline : local_deadline);
+		}
+
+		static std::shared_ptr<guard_worker> start_worker() {
+			std::shared_ptr<guard_worker> worker = std::make_shared<guard_worker>();
+			std::thread(serve, worker).detach();
+			return worker;
+		}
+
+	public:
+
+		// true if the path is on a network or fuse mount known to be slow
+		static bool remote(const std::string &path) {
+			return shared().mounts.find(path).remote;
+		}
+
+		// false if work did not finish before the deadline of the mount the
+		// path is on, or that mount is already hung
+		static bool run(const std::string &path, std::function<void()> work) {
+			state &guard = shared();
+			mount_entry mount = guard.mounts.find(path);
+
+			{
+				std::lock_guard<std::mutex> lock(guard.mutex);
+				if(guard.hung.count(mount.point) != 0) {
+					return false;
+				}
+			}
+
+			if(guard.worker == nullptr) {
+				guard.worker = start_worker();
+			}
+
+			std::shared_ptr<guard_job> job = std::make_shared<guard_job>();
+			job->work = std::move(work);
+			job->mount = mount.point;
+
+			{
+				std::lock_guard<std::mutex> lock(guard.worker->mutex);
+				guard.worker->job = job;
+			}
+			guard.worker->wake.notify_one();
+
+			std::unique_lock<std::mutex> lock(job->mutex);
+			bool done = job->finished.wait_for(lock, deadline(mount), [&]() { return job->done; });
+
+			if(!done) {
+				job->abandoned = true;
+				lock.unlock();
+
+				{
+					std::lock_guard<std::mutex> hung_lock(guard.mutex);
+					guard.hung.insert(mount.point);
+				}
+
+				// the stuck worker is left to finish on its own
+				{
+					std::lock_guard<std::mutex> worker_lock(guard.worker->mutex);
+					guard.worker->retired = true;
+				}
+				guard.worker = start_worker();
+			}
+
+			return done;
+		}
+
+		// long work, a whole directory read or a sum of sizes, on a thread of
+		// its own without a deadline. nullptr if the mount of path is hung,
+		// the work is not started then. without waited nobody waits for it
+		// and recovered tells when it is done
+		static std::shared_ptr<guard_job> start(const std::string &path, std::function<void()> work, bool waited) {
+			state &guard = shared();
+			mount_entry mount = guard.mounts.find(path);
+
+			{
+				std::lock_guard<std::mutex> lock(guard.mutex);
+				if(guard.hung.count(mount.point) != 0) {
+					return nullptr;
+				}
+			}
+
+			std::shared_ptr<guard_job> job = std::make_shared<guard_job>();
+			job->work = std::move(work);
+			job->mount = mount.point;
+			job->abandoned = !waited;
+
+			std::thread([job]() {
+				job->work();
+
+				bool abandoned;
+				{
+					std::lock_guard<std::mutex> lock(job->mutex);
+					job->done = true;
+					abandoned = job->abandoned;
+				}
+				job->finished.notify_one();
+
+				if(abandoned) {
+					announce(job->mount);
+				}
+			}).detach();
+
+			return job;
+		}
+
+		// waits for started work until the deadline of its mount. a job that
+		// misses it is left to go on, and a stat of path tells a slow job
+		// from a hung mount. false if the work has not finished
+		static bool wait(const std::string &path, const std::shared_ptr<guard_job> &job) {
+			{
+				std::unique_lock<std::mutex> lock(job->mutex);
+				if(job->finished.wait_for(lock, deadline(shared().mounts.find(path)), [&]() { return job->done; })) {
+					return true;
+				}
+				job->abandoned = true;
+			}
+
+			struct stat info;
+			stat(path, info);
+			return false;
+		}
+
+		// stat through the guard, errno is ETIMEDOUT if it did not answer
+		static bool stat(const std::string &path, struct stat &info) {
+			std::shared_ptr<std::pair<int, struct statx>> result = std::make_shared<std::pair<int, struct statx>>();
+
+			if(!run(path, [result, path]() {
+				result->first = vfs::current().stat(path, result->second);
+			})) {
+				errno = ETIMEDOUT;
+				return false;
+			}
+
+			errno = result->first;
+			if(result->first != 0) {
+				return false;
+			}
+
+			const struct statx &found = result->second;
+			memset(&info, 0, sizeof(info));
+			info.st_dev = makedev(found.stx_dev_major, found.stx_dev_minor);
+			info.st_ino = found.stx_ino;
+			info.st_mode = found.stx_mode;
+			info.st_size = found.stx_size;
+			info.st_mtim = { found.stx_mtime.tv_sec, found.stx_mtime.tv_nsec };
+			info.st_ctim = { found.stx_ctime.tv_sec, found.stx_ctime.tv_nsec };
+			return true;
+		}
+
+		// true if the mount of path is taken as hung
+		static bool hung(const std::string &path) {
+			state &guard = shared();
+			mount_entry mount = guard.mounts.find(path);
+			std::lock_guard<std::mutex> lock(guard.mutex);
+			return guard.hung.count(mount.point) != 0;
+		}
+
+		static int get_fd() {
+			return shared().fd;
+		}
+
+		// true once after a hung mount answered again or work nobody
+		// waited for finished
+		static bool recovered() {
+			unsigned long long count;
+			stats::syscalls++;
+			if(::read(shared().fd, &count, sizeof(count)) < 0) {
+				return false;
+			}
+
+			std::lock_guard<std::mutex> lock(shared().mutex);
+			bool result = shared().recovered;
+			shared().recovered = false;
+			return result;
+		}
+};
+
+# endif
@@ -0,0 +1,50 @@
+# ifndef HISTORY_H
+# define HISTORY_H
+
+// last selected name per directory, oldest forgotten first
+class file_history {
+	private:
+
+		typedef std::list<std::pair<std::string, std::string>> entries;
+
+		entries order;
+		std::unordered_map<std::string, entries::iterator> directories;
+
+	public:
+
+		void set(std::string directory, std::string filename) {
+			auto iterator = directories.find(directory);
+			if(iterator != directories.end()) {
+				order.erase(iterator->second);
+			}
+
+			order.push_front({ directory, filename });
+			directories[directory] = order.begin();
+
+			if(order.size() > max_file_history) {
+				directories.erase(order.back().first);
+				order.pop_back();
+			}
+		}
+
+		// last selected name in directory, empty if none
+		std::string get(std::string directory) {
+			auto iterator = directories.find(directory);
+			if(iterator == directories.end()) {
+				return "";
+			}
+
+			order.splice(order.begin(), order, iterator->second);
+			return iterator->second->second;
+		}
+
+		void erase(std::string directory) {
+			auto iterator = directories.find(directory);
+			if(iterator != directories.end()) {
+				order.erase(iterator->second);
+				directories.erase(iterator);
+			}
+		}
+};
+
+# endif
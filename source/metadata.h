@@ -0,0 +1,109 @@
+# ifndef METADATA_H
+# define METADATA_H
+
+// ls -l style columns of a listing. rows are filled for the part that
+// gets drawn, one batch of statx against an open directory, and kept until
+// the listing is replaced, so scrolling back over them costs nothing
+class long_columns {
+	private:
+
+		std::shared_ptr<const listing> source;
+
+		// empty until the row has been stat'ed
+		std::vector<std::string> rows;
+
+		// false while the directory does not answer, its rows stay empty
+		bool answered = true;
+
+		static std::string format(const struct statx &info) {
+			char type = S_ISDIR(info.stx_mode) ? 'd' : S_ISLNK(info.stx_mode) ? 'l' : '-';
+			std::string owner = commands::file_owner(info.stx_uid, info.stx_gid);
+
+			if(owner.length() > long_owner_width) {
+				owner.resize(long_owner_width);
+			}
+
+			return type + commands::file_permissions(info.stx_mode) + " "
+				+ owner + std::string(long_owner_width - owner.length() + 1, ' ')
+				+ commands::file_last_mod_time(info.stx_mtime.tv_sec);
+		}
+
+	public:
+
+		// width of every row, they all line up
+		static int width() {
+			return 10 + 1 + long_owner_width + 1 + 16;
+		}
+
+		// fills the missing rows from first up to count rows after it
+		void prepare(std::shared_ptr<const listing> elements, std::string directory, int first, int count) {
+			if(elements != source) {
+				source = elements;
+				rows.assign(elements->size(), "");
+				answered = true;
+			}
+
+			int last = std::min(first + count, static_cast<int>(rows.size()));
+
+			int missing = first;
+			while(missing < last && !rows[missing].empty()) {
+				missing++;
+			}
+			if(missing == last) {
+				return;
+			}
+
+			// stat'ed off the ui thread, the directory may be on a mount that hangs
+			struct batch_result {
+				std::vector<std::string> names;
+				std::vector<struct statx> results;
+				std::vector<int> errors;
+			};
+
+			std::shared_ptr<batch_result> batch = std::make_shared<batch_result>();
+			std::vector<int> indices;
+			for(int i = missing; i < last; i++) {
+				if(rows[i].empty()) {
+					batch->names.emplace_back(elements->name(i));
+					if(batch->names.back().back() == '/') {
+						batch->names.back().pop_back();
+					}
+					indices.push_back(i);
+				}
+			}
+
+			answered = fs_guard::run(directory, [batch, directory]() {
+				// names are looked up relative to the directory, not the cwd
+				std::unique_ptr<vfs_directory> opened = vfs::current().open_directory(directory);
+
+				std::vector<const char*> names;
+				for(const auto &name : batch->names) {
+					names.push_back(name.c_str());
+				}
+
+				opened->stat(names, AT_SYMLINK_NOFOLLOW | AT_STATX_DONT_SYNC,
+						STATX_TYPE | STATX_MODE | STATX_UID | STATX_GID | STATX_MTIME, batch->results, batch->errors);
+			});
+
+			for(int i = 0; answered && i < indices.size(); i++) {
+				if(batch->errors[i] == 0) {
+					rows[indices[i]] = format(batch->results[i]);
+				} else {
+					rows[indices[i]] = std::string(width(), '?');
+				}
+			}
+		}
+
+		std::string_view row(int index) const {
+			static const std::string unresponsive = std::string("unresponsive").append(width() - 12, ' ');
+
+			if(index < 0 || index >= rows.size()) {
+				return std::string_view();
+			} else if(rows[index].empty() && !answered) {
+				return unresponsive;
+			}
+			return rows[index];
+		}
+};
+
+# endif
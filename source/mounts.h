@@ -0,0 +1,104 @@
+# ifndef MOUNTS_H
+# define MOUNTS_H
+
+struct mount_entry {
+	std::string point;
+	std::string type;
+	bool remote;
+};
+
+// the mounts of this process from /proc/self/mountinfo, read again when
+// the kernel flags the file as changed
+class mount_table {
+	private:
+
+		int fd = -1;
+		std::vector<mount_entry> mounts;
+
+		// mountinfo escapes spaces and the like as \ooo
+		static std::string unescape(std::string_view field) {
+			std::string result;
+			for(std::size_t i = 0; i < field.length(); i++) {
+				if(field[i] == '\\' && i + 3 < field.length()) {
+					result += static_cast<char>((field[i + 1] - '0') * 64 + (field[i + 2] - '0') * 8 + (field[i + 3] - '0'));
+					i += 3;
+				} else {
+					result += field[i];
+				}
+			}
+			return result;
+		}
+
+		void load() {
+			mounts.clear();
+
+			std::string content;
+			char buffer[65536];
+			lseek(fd, 0, SEEK_SET);
+
+			ssize_t length;
+			while((length = ::read(fd, buffer, sizeof(buffer))) > 0) {
+				stats::syscalls++;
+				content.append(buffer, length);
+			}
+
+			std::istringstream stream(content);
+			std::string line;
+			while(std::getline(stream, line)) {
+				std::vector<std::string> fields;
+				boost::split(fields, line, boost::is_any_of(" "));
+
+				// the type follows the "-" that ends the optional fields
+				auto separator = std::find(fields.begin() + std::min<std::size_t>(6, fields.size()), fields.end(), "-");
+				if(fields.size() < 5 || separator == fields.end() || separator + 1 == fields.end()) {
+					continue;
+				}
+
+				std::string type = *(separator + 1);
+				bool remote = std::find(remote_filesystems.begin(), remote_filesystems.end(), type) != remote_filesystems.end();
+				mounts.push_back({ unescape(fields[4]), type, remote });
+			}
+		}
+
+	public:
+
+		mount_table() {
+			fd = ::open("/proc/self/mountinfo", O_RDONLY | O_CLOEXEC);
+			if(fd != -1) {
+				load();
+			}
+		}
+
+		~mount_table() {
+			if(fd != -1) {
+				close(fd);
+			}
+		}
+
+		// the mount a path lies on, the longest mount point that prefixes it
+		mount_entry find(const std::string &path) {
+			if(fd != -1) {
+				struct pollfd descriptor = { fd, POLLPRI, 0 };
+				stats::syscalls++;
+				if(poll(&descriptor, 1, 0) > 0 && (descriptor.revents & (POLLPRI | POLLERR))) {
+					load();
+				}
+			}
+
+			const mount_entry *best = nullptr;
+			for(const auto &entry : mounts) {
+				const std::string &point = entry.point;
+				bool prefix = path.compare(0, point.length(), point) == 0
+					&& (point == "/" || path.length() == point.length() || path[point.length()] == '/');
+
+				// later mounts hide earlier ones on the same point
+				if(prefix && (best == nullptr || point.length() >= best->point.length())) {
+					best = &entry;
+				}
+			}
+
+			return best != nullptr ? *best : mount_entry { "/", "", false };
+		}
+};
+
+# endif
@@ -0,0 +1,116 @@
+# ifndef READER_H
+# define READER_H
+
+// reads a directory straight from getdents64. names point into the
+// buffer and are only valid until the next call, nothing is allocated
+// per entry and no paths are built. d_type is DT_UNKNOWN on filesystems
+// that do not fill it, callers stat those
+class directory_reader {
+	private:
+
+		int fd = -1;
+		bool owns_fd = false;
+		int error = 0;
+
+		std::vector<char> buffer;
+		bool shared = false;
+		int position = 0;
+		int end = 0;
+
+		// one buffer per thread is kept between readers, nested readers make their own
+		static std::vector<char> &spare() {
+			static thread_local std::vector<char> buffer;
+			return buffer;
+		}
+
+		static bool &spare_taken() {
+			static thread_local bool taken = false;
+			return taken;
+		}
+
+		void take_buffer() {
+			if(!spare_taken()) {
+				spare_taken() = true;
+				shared = true;
+				buffer.swap(spare());
+			}
+			if(buffer.size() != directory_buffer_size) {
+				buffer.resize(directory_buffer_size);
+			}
+		}
+
+	public:
+
+		directory_reader(std::string directory) {
+			stats::syscalls++;
+			fd = ::open(directory.c_str(), O_RDONLY | O_DIRECTORY | O_CLOEXEC);
+			error = fd == -1 ? errno : 0;
+			owns_fd = true;
+			take_buffer();
+		}
+
+		// reads an already open directory from its current offset
+		directory_reader(int fd_) : fd(fd_) {
+			take_buffer();
+		}
+
+		~directory_reader() {
+			if(owns_fd && fd != -1) {
+				close(fd);
+			}
+
+			if(shared) {
+				buffer.swap(spare());
+				spare_taken() = false;
+			}
+		}
+
+		bool is_open() const {
+			return fd != -1;
+		}
+
+		int get_fd() const {
+			return fd;
+		}
+
+		// errno of opening the directory
+		int get_error() const {
+			return error;
+		}
+
+		// next entry other than . and .., false at the end or on an error
+		bool next(std::string_view &name, unsigned char &type, ino_t &inode) {
+			while(true) {
+				if(position >= end) {
+					if(fd == -1) {
+						return false;
+					}
+
+					stats::syscalls++;
+					long count = syscall(SYS_getdents64, fd, buffer.data(), buffer.size());
+					if(count <= 0) {
+						return false;
+					}
+
+					stats::bytes_read += count;
+					position = 0;
+					end = count;
+				}
+
+				const struct dirent64 *entry = reinterpret_cast<const struct dirent64*>(buffer.data() + position);
+				position += entry->d_reclen;
+
+				const char *entry_name = entry->d_name;
+				if(entry_name[0] == '.' && (entry_name[1] == '\0' || (entry_name[1] == '.' && entry_name[2] == '\0'))) {
+					continue;
+				}
+
+				name = std::string_view(entry_name);
+				type = entry->d_type;
+				inode = entry->d_ino;
+				return true;
+			}
+		}
+};
+
+# endif
@@ -0,0 +1,172 @@
+# ifndef REGISTERS_H
+# define REGISTERS_H
+
+// named registers of absolute paths, like the ones of vi. yanking and
+// pasting stay in the process. what goes into the unnamed register can
+// also be handed to the clipboard of the terminal or of X, and '+' is
+// read back from X when there is one
+class registers {
+	private:
+
+		std::unordered_map<char, std::vector<std::string>> contents;
+
+		static std::string join(const std::vector<std::string> &paths) {
+			std::size_t length = 0;
+			for(const auto &path : paths) {
+				length += path.length() + 1;
+			}
+
+			std::string result;
+			result.reserve(length);
+			for(const auto &path : paths) {
+				if(!result.empty()) {
+					result += '\n';
+				}
+				result += path;
+			}
+			return result;
+		}
+
+		static std::string base64(const std::string &data) {
+			static const char digits[] = "ABCDEFGHIJKLMNOPQRSTUVWXYZabcdefghijklmnopqrstuvwxyz0123456789+/";
+
+			std::string result;
+			result.reserve((data.length() + 2) / 3 * 4);
+
+			for(std::size_t i = 0; i < data.length(); i += 3) {
+				unsigned int word = static_cast<unsigned char>(data[i]) << 16;
+				if(i + 1 < data.length()) {
+					word |= static_cast<unsigned char>(data[i + 1]) << 8;
+				}
+				if(i + 2 < data.length()) {
+					word |= static_cast<unsigned char>(data[i + 2]);
+				}
+
+				result += digits[(word >> 18) & 63];
+				result += digits[(word >> 12) & 63];
+				result += i + 1 < data.length() ? digits[(word >> 6) & 63] : '=';
+				result += i + 2 < data.length() ? digits[word & 63] : '=';
+			}
+			return result;
+		}
+
+		static bool has_display() {
+			const char *display = getenv("DISPLAY");
+			return display != nullptr && display[0] != '\0';
+		}
+
+		// osc 52 sets the clipboard of the terminal, also over ssh
+		static bool export_terminal(const std::string &text) {
+			if(text.length() > max_osc52_size) {
+				return false;
+			}
+
+			std::string sequence = "\033]52;c;" + base64(text) + "\a";
+			stats::syscalls++;
+			return ::write(STDOUT_FILENO, sequence.data(), sequence.length()) == static_cast<ssize_t>(sequence.length());
+		}
+
+		// the command is fixed, paths only go through the pipe
+		static bool export_x(const std::string &text) {
+			if(!has_display()) {
+				return false;
+			}
+
+			FILE *pipe = popen("xclip -selection clipboard 2>/dev/null", "w");
+			if(pipe == nullptr) {
+				return false;
+			}
+			fwrite(text.data(), 1, text.length(), pipe);
+			return pclose(pipe) == 0;
+		}
+
+		static std::vector<std::string> import_x() {
+			std::vector<std::string> result;
+			if(!has_display()) {
+				return result;
+			}
+
+			FILE *pipe = popen("xclip -selection clipboard -o 2>/dev/null", "r");
+			if(pipe == nullptr) {
+				return result;
+			}
+
+			std::string text;
+			char buffer[65536];
+			std::size_t length;
+			while((length = fread(buffer, 1, sizeof(buffer), pipe)) > 0) {
+				text.append(buffer, length);
+			}
+			pclose(pipe);
+
+			boost::split(result, text, boost::is_any_of("\n"));
+			result.erase(std::remove(result.begin(), result.end(), ""), result.end());
+			return result;
+		}
+
+	public:
+
+		// registers are letters, '"' is the unnamed one and '+' is the clipboard
+		static bool valid(char name) {
+			return name == '"' || name == '+' || std::isalpha(static_cast<unsigned char>(name));
+		}
+
+		// uppercase names append to their lowercase register like in vi.
+		// false if an export was asked for and did not go through
+		bool yank(char name, std::vector<std::string> paths) {
+			bool exported = true;
+
+			if(name == '+' || (name == '"' && clipboard_export != 0)) {
+				std::string text = join(paths);
+				exported = clipboard_export == 2 || (name == '+' && has_display()) ? export_x(text) : export_terminal(text);
+			}
+
+			if(std::isupper(static_cast<unsigned char>(name))) {
+				std::vector<std::string> &target = contents[std::tolower(name)];
+				target.insert(target.end(), std::make_move_iterator(paths.begin()), std::make_move_iterator(paths.end()));
+				contents['"'] = target;
+			} else {
+				if(name != '"') {
+					contents['"'] = paths;
+				}
+				contents[name] = std::move(paths);
+			}
+
+			return exported;
+		}
+
+		// '+' is read from X if it can be, what was yanked into it otherwise
+		std::vector<std::string> get(char name) {
+			if(name == '+') {
+				std::vector<std::string> clipboard = import_x();
+				if(!clipboard.empty()) {
+					return clipboard;
+				}
+			}
+
+			auto iterator = contents.find(std::tolower(name));
+			return iterator != contents.end() ? iterator->second : std::vector<std::string>();
+		}
+
+		// "x 12 /first/path" per register
+		std::string describe() const {
+			std::vector<char> names;
+			for(const auto &content : contents) {
+				names.push_back(content.first);
+			}
+			std::sort(names.begin(), names.end());
+
+			std::string result;
+			for(char name : names) {
+				const std::vector<std::string> &paths = contents.at(name);
+				if(!result.empty()) {
+					result += "  ";
+				}
+				result += std::string(1, name) + " " + std::to_string(paths.size())
+					+ (paths.empty() ? "" : " " + paths.front());
+			}
+			return result;
+		}
+};
+
+# endif
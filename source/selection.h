@@ -0,0 +1,93 @@
+# ifndef SELECTION_H
+# define SELECTION_H
+
+// marked entries of a listing, one bit per entry
+class selection {
+	private:
+
+		std::vector<unsigned long long> bits;
+		std::size_t length = 0;
+		std::size_t count = 0;
+
+		// keeps bits past the end at zero so counting stays exact
+		void trim() {
+			if(length % 64 != 0) {
+				bits.back() &= (1ULL << (length % 64)) - 1;
+			}
+		}
+
+	public:
+
+		// drops every mark and sizes the selection to a listing
+		void reset(std::size_t length_) {
+			length = length_;
+			count = 0;
+			bits.assign((length + 63) / 64, 0);
+		}
+
+		std::size_t size() const {
+			return count;
+		}
+
+		bool empty() const {
+			return count == 0;
+		}
+
+		bool test(std::size_t index) const {
+			return index < length && (bits[index / 64] >> (index % 64)) & 1;
+		}
+
+		void set(std::size_t index, bool value) {
+			if(index >= length || test(index) == value) {
+				return;
+			}
+			bits[index / 64] ^= 1ULL << (index % 64);
+			count += value ? 1 : -1;
+		}
+
+		void toggle(std::size_t index) {
+			set(index, !test(index));
+		}
+
+		void clear() {
+			std::fill(bits.begin(), bits.end(), 0);
+			count = 0;
+		}
+
+		void set_all() {
+			std::fill(bits.begin(), bits.end(), ~0ULL);
+			trim();
+			count = length;
+		}
+
+		void invert() {
+			for(auto &word : bits) {
+				word = ~word;
+			}
+			trim();
+			count = length - count;
+		}
+
+		// marks first to last, both included
+		void set_range(std::size_t first, std::size_t last) {
+			for(std::size_t i = first; i <= last && i < length; i++) {
+				set(i, true);
+			}
+		}
+
+		// marked indices in order
+		std::vector<int> indices() const {
+			std::vector<int> result;
+			result.reserve(count);
+			for(std::size_t i = 0; i < bits.size(); i++) {
+				unsigned long long word = bits[i];
+				while(word != 0) {
+					result.push_back(i * 64 + __builtin_ctzll(word));
+					word &= word - 1;
+				}
+			}
+			return result;
+		}
+};
+
+# endif
@@ -0,0 +1,140 @@
+std::vector<trace_event> stats::events;
+std::vector<frame_timing> stats::current_frame;
+std::vector<frame_timing> stats::last_frame;
+
+unsigned long stats::frame_start = stats::now();
+unsigned long stats::last_frame_time = 0;
+unsigned long stats::idle_start = 0;
+unsigned long stats::idle_time = 0;
+
+int stats::frame_keys = 0;
+int stats::last_frame_keys = 0;
+
+std::atomic<unsigned long> stats::syscalls(0);
+std::atomic<unsigned long> stats::bytes_read(0);
+std::atomic<unsigned long> stats::allocations(0);
+std::atomic<unsigned long> stats::allocated_bytes(0);
+
+bool stats::overlay = false;
+
+/* allocation counting */
+
+void *operator new(std::size_t size) {
+	stats::allocations.fetch_add(1, std::memory_order_relaxed);
+	stats::allocated_bytes.fetch_add(size, std::memory_order_relaxed);
+
+	void *pointer = malloc(size == 0 ? 1 : size);
+	if(!pointer) {
+		throw std::bad_alloc();
+	}
+	return pointer;
+}
+
+void operator delete(void *pointer) noexcept {
+	free(pointer);
+}
+
+void operator delete(void *pointer, std::size_t) noexcept {
+	free(pointer);
+}
+
+/* timing */
+
+// microseconds since an arbitrary point
+unsigned long stats::now() {
+	return std::chrono::duration_cast<std::chrono::microseconds>
+		(std::chrono::steady_clock::now().time_since_epoch()).count();
+}
+
+void stats::record(std::string name, unsigned long start, unsigned long duration) {
+	// keep the trace bounded, oldest half goes first
+	if(events.size() >= max_trace_events) {
+		events.erase(events.begin(), events.begin() + events.size() / 2);
+	}
+	events.push_back({ name, start, duration });
+
+	for(int i = 0; i < current_frame.size(); i++) {
+		if(current_frame[i].name == name) {
+			current_frame[i].total += duration;
+			current_frame[i].calls++;
+			return;
+		}
+	}
+	current_frame.push_back({ name, duration, 1 });
+}
+
+// closes the running frame so the overlay shows complete numbers
+void stats::next_frame() {
+	unsigned long time = now();
+	last_frame_time = time - frame_start - idle_time;
+	frame_start = time;
+	idle_time = 0;
+
+	last_frame = current_frame;
+	current_frame.clear();
+
+	last_frame_keys = frame_keys;
+	frame_keys = 0;
+}
+
+// time spent waiting for input is not part of the frame
+void stats::begin_idle() {
+	idle_start = now();
+}
+
+void stats::end_idle() {
+	idle_time += now() - idle_start;
+}
+
+// keys handled before the frame was drawn
+void stats::count_key() {
+	frame_keys++;
+}
+
+std::vector<std::string> stats::overlay_lines() {
+	std::vector<std::string> lines;
+	std::stringstream stream;
+	stream << std::fixed << std::setprecision(2);
+
+	stream << "frame " << last_frame_time / 1000.0 << "ms";
+	lines.push_back(stream.str());
+	lines.push_back("keys " + std::to_string(last_frame_keys));
+
+	for(const auto &timing : last_frame) {
+		stream.str("");
+		stream << timing.name << " " << timing.total / 1000.0 << "ms";
+		if(timing.calls > 1) {
+			stream << " x" << timing.calls;
+		}
+		lines.push_back(stream.str());
+	}
+
+	lines.push_back("syscalls " + std::to_string(syscalls));
+	lines.push_back("read " + commands::format_file_size(bytes_read, size_precision));
+	lines.push_back("allocs " + std::to_string(allocations)
+			+ " (" + commands::format_file_size(allocated_bytes, size_precision) + ")");
+
+	return lines;
+}
+
+// writes every recorded event in chrome trace event format
+bool stats::dump(std::string filename) {
+	std::ofstream write(filename);
+	if(!write) {
+		return false;
+	}
+
+	write << "{\"traceEvents\":[";
+	for(int i = 0; i < events.size(); i++) {
+		std::string name = commands::find_and_replace(events[i].name, "\\", "\\\\");
+		name = commands::find_and_replace(name, "\"", "\\\"");
+
+		write << (i == 0 ? "" : ",") << "\n{\"name\":\"" << name
+			<< "\",\"ph\":\"X\",\"pid\":1,\"tid\":1,\"ts\":" << events[i].start
+			<< ",\"dur\":" << events[i].duration << "}";
+	}
+	write << "\n],\"displayTimeUnit\":\"ms\"}\n";
+	write.close();
+
+	return !write.fail();
+}
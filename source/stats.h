@@ -0,0 +1,68 @@
+# ifndef STATS_H
+# define STATS_H
+
+struct trace_event {
+	std::string name;
+	unsigned long start;
+	unsigned long duration;
+};
+
+struct frame_timing {
+	std::string name;
+	unsigned long total;
+	int calls;
+};
+
+class stats {
+	private:
+
+		static std::vector<trace_event> events;
+		static std::vector<frame_timing> current_frame;
+		static std::vector<frame_timing> last_frame;
+
+		static unsigned long frame_start;
+		static unsigned long last_frame_time;
+		static unsigned long idle_start;
+		static unsigned long idle_time;
+
+		static int frame_keys;
+		static int last_frame_keys;
+
+	public:
+
+		/* counters, worker threads count too */
+
+		static std::atomic<unsigned long> syscalls;
+		static std::atomic<unsigned long> bytes_read;
+		static std::atomic<unsigned long> allocations;
+		static std::atomic<unsigned long> allocated_bytes;
+
+		static bool overlay;
+
+		static unsigned long now();
+		static void record(std::string name, unsigned long start, unsigned long duration);
+		static void next_frame();
+		static void begin_idle();
+		static void end_idle();
+		static void count_key();
+		static std::vector<std::string> overlay_lines();
+		static bool dump(std::string filename);
+};
+
+// times the scope it lives in and records it as a trace event
+class scoped_timer {
+	private:
+
+		std::string name;
+		unsigned long start;
+
+	public:
+
+		scoped_timer(std::string name_) : name(name_), start(stats::now()) {}
+
+		~scoped_timer() {
+			stats::record(name, start, stats::now() - start);
+		}
+};
+
+# endif
@@ -0,0 +1,193 @@
+# ifndef SURFACE_H
+# define SURFACE_H
+
+// something the user interface can draw on
+class surface {
+	public:
+
+		virtual ~surface() {}
+
+		virtual int get_width() = 0;
+		virtual int get_height() = 0;
+
+		virtual void move(int y, int x, int height, int width) = 0;
+		virtual void print(int y, int x, std::string text, int attributes = 0) = 0;
+		virtual void clear() = 0;
+		virtual void refresh() = 0;
+
+	protected:
+
+		// cuts text at the right edge without splitting a utf-8 character
+		static std::string clip(std::string text, int x, int width) {
+			if(x >= width) {
+				return "";
+			}
+
+			if(text.length() > width - x) {
+				int length = width - x;
+				while(length > 0 && (text[length] & 0xC0) == 0x80) {
+					length--;
+				}
+				text.erase(length);
+			}
+
+			return text;
+		}
+};
+
+// draws to a real terminal through ncurses
+class ncurses_surface : public surface {
+	private:
+
+		WINDOW *window;
+
+	public:
+
+		ncurses_surface(WINDOW *window_) : window(window_) {}
+
+		~ncurses_surface() {
+			if(window != stdscr) {
+				delwin(window);
+			}
+		}
+
+		int get_width() {
+			return getmaxx(window);
+		}
+
+		int get_height() {
+			return getmaxy(window);
+		}
+
+		void move(int y, int x, int height, int width) {
+			wresize(window, height, width);
+			mvwin(window, y, x);
+		}
+
+		void print(int y, int x, std::string text, int attributes = 0) {
+			wattron(window, attributes);
+			mvwaddstr(window, y, x, clip(text, x, get_width()).c_str());
+			wattroff(window, attributes);
+		}
+
+		void clear() {
+			werase(window);
+		}
+
+		void refresh() {
+			wrefresh(window);
+		}
+};
+
+struct cell {
+	char character = ' ';
+	int attributes = 0;
+
+	bool operator==(const cell &other) const {
+		return character == other.character && attributes == other.attributes;
+	}
+};
+
+// draws to an in-memory cell grid, used without a terminal
+class memory_surface : public surface {
+	private:
+
+		int width = 0, height = 0;
+
+		// what is being drawn and what was last refreshed
+		std::vector<cell> back;
+		std::vector<cell> front;
+
+		unsigned long damage = 0;
+		unsigned long total_damage = 0;
+
+	public:
+
+		memory_surface(int height_, int width_) {
+			move(0, 0, height_, width_);
+		}
+
+		int get_width() {
+			return width;
+		}
+
+		int get_height() {
+			return height;
+		}
+
+		// position does not matter offscreen, only the size
+		void move(int y, int x, int height_, int width_) {
+			if(height_ == height && width_ == width) {
+				return;
+			}
+
+			height = std::max(height_, 0);
+			width = std::max(width_, 0);
+			back.assign(width * height, cell());
+			front.assign(width * height, cell());
+		}
+
+		void print(int y, int x, std::string text, int attributes = 0) {
+			if(y < 0 || y >= height || x < 0) {
+				return;
+			}
+
+			text = clip(text, x, width);
+			for(int i = 0; i < text.length(); i++) {
+				back[y * width + x + i] = { text[i], attributes };
+			}
+		}
+
+		void clear() {
+			std::fill(back.begin(), back.end(), cell());
+		}
+
+		// counts the cells that changed since the last refresh
+		void refresh() {
+			damage = 0;
+			for(int i = 0; i < back.size(); i++) {
+				if(!(back[i] == front[i])) {
+					damage++;
+				}
+			}
+			total_damage += damage;
+			front = back;
+		}
+
+		unsigned long get_damage() {
+			return damage;
+		}
+
+		unsigned long get_total_damage() {
+			return total_damage;
+		}
+
+		std::vector<std::string> snapshot() {
+			std::vector<std::string> lines;
+			for(int i = 0; i < height; i++) {
+				std::string line;
+				for(int j = 0; j < width; j++) {
+					line += front[i * width + j].character;
+				}
+				lines.push_back(line);
+			}
+			return lines;
+		}
+
+		// amount of cells that differ from another surface of the same size
+		int diff(memory_surface &other) {
+			if(width != other.width || height != other.height) {
+				return -1;
+			}
+
+			int sum = 0;
+			for(int i = 0; i < front.size(); i++) {
+				if(!(front[i] == other.front[i])) {
+					sum++;
+				}
+			}
+			return sum;
+		}
+};
+
+# endif
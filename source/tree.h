@@ -0,0 +1,237 @@
+# ifndef TREE_H
+# define TREE_H
+
+// the main pane as a tree. expanded directories are listed below their
+// entry, read off the ui thread the first time and handed to the listing
+// cache, which keeps them patched like any other. the tree is flattened
+// into one listing whose names are paths relative to the current
+// directory, so every command works on it unchanged. it is only flattened
+// again when one of the listings in it was replaced, scrolling and drawing
+// never walk more than the rows on screen. a collapsed directory keeps
+// nothing, expanding it again is a cache hit
+class directory_tree {
+	private:
+
+		struct load {
+			std::string directory;
+			std::shared_ptr<listing> elements;
+			int error;
+		};
+
+		// loads that finished, handed over from their threads
+		struct finished_loads {
+			std::mutex mutex;
+			std::vector<load> loads;
+		};
+
+		std::shared_ptr<finished_loads> finished = std::make_shared<finished_loads>();
+		int fd = -1;
+
+		std::string root;
+
+		// expanded directories relative to the root, with their slash, and
+		// the listing each was last seen with
+		std::unordered_map<std::string, std::shared_ptr<const listing>> expanded;
+
+		// full paths being read
+		std::unordered_set<std::string> loading;
+
+		// what the last flattened listing was made of
+		std::shared_ptr<const listing> source;
+		std::vector<std::shared_ptr<const listing>> parts;
+		std::shared_ptr<const listing> flattened;
+
+		std::string full_path(const std::string &relative) const {
+			return (root == "/" ? "" : root) + "/" + relative.substr(0, relative.length() - 1);
+		}
+
+		void start_load(const std::string &directory) {
+			if(!loading.insert(directory).second) {
+				return;
+			}
+
+			std::shared_ptr<finished_loads> done = finished;
+			bool count_items = !fs_guard::remote(directory);
+			int event = fd;
+
+			// a hung mount only keeps its own thread, the directory shows as loading
+			std::thread([done, directory, count_items, event]() {
+				load result = { directory, std::make_shared<listing>(), 0 };
+				result.elements->hidden = show_hidden;
+
+				struct statx info;
+				result.error = vfs::current().stat(directory, info);
+				if(result.error == 0) {
+					result.elements->mtime = { info.stx_mtime.tv_sec, info.stx_mtime.tv_nsec };
+					result.elements->ctime = { info.stx_ctime.tv_sec, info.stx_ctime.tv_nsec };
+					commands::read_directory(directory, std::numeric_limits<int>::max(), *result.elements, count_items);
+				}
+
+				{
+					std::lock_guard<std::mutex> lock(done->mutex);
+					done->loads.push_back(std::move(result));
+				}
+				unsigned long long one = 1;
+				if(::write(event, &one, sizeof(one)) < 0) {
+					return;
+				}
+			}).detach();
+		}
+
+		// the listing of an expanded directory, the cache has the newest
+		std::shared_ptr<const listing> child(const std::string &relative, listing_cache &cache) {
+			auto node = expanded.find(relative);
+			std::shared_ptr<const listing> elements = cache.current(full_path(relative), std::numeric_limits<int>::max());
+			if(elements != nullptr) {
+				node->second = elements;
+			} else if(node->second != nullptr && node->second->hidden != show_hidden) {
+				node->second = nullptr;
+			}
+
+			if(node->second == nullptr) {
+				start_load(full_path(relative));
+			}
+			return node->second;
+		}
+
+		// expanded directories belong to the directory they were opened in
+		void move_to(const std::string &directory) {
+			if(directory != root) {
+				root = directory;
+				expanded.clear();
+				flattened = nullptr;
+			}
+		}
+
+		void append(listing &result, const listing &elements, const std::string &prefix) {
+			for(std::size_t i = 0; i < elements.size(); i++) {
+				std::string name = prefix + std::string(elements.name(i));
+				bool open = name.back() == '/' && expanded.count(name) != 0;
+				std::shared_ptr<const listing> children = open ? expanded[name] : nullptr;
+
+				result.add(name, open && children == nullptr ? "..." : elements.file_size(i), elements.inode(i));
+				if(children != nullptr) {
+					append(result, *children, name);
+				}
+			}
+		}
+
+	public:
+
+		directory_tree() {
+			fd = eventfd(0, EFD_NONBLOCK | EFD_CLOEXEC);
+		}
+
+		~directory_tree() {
+			if(fd != -1) {
+				close(fd);
+			}
+		}
+
+		int get_fd() const {
+			return fd;
+		}
+
+		// hands finished loads to the cache, true if the tree changed
+		bool collect(listing_cache &cache) {
+			unsigned long long count;
+			stats::syscalls++;
+			if(fd == -1 || ::read(fd, &count, sizeof(count)) != sizeof(count)) {
+				return false;
+			}
+
+			std::vector<load> loads;
+			{
+				std::lock_guard<std::mutex> lock(finished->mutex);
+				loads.swap(finished->loads);
+			}
+
+			bool changed = false;
+			for(auto &result : loads) {
+				loading.erase(result.directory);
+
+				// expanded elsewhere or collapsed meanwhile, the cache still takes it
+				std::string prefix = (root == "/" ? "" : root) + "/";
+				std::string relative = result.directory.compare(0, prefix.length(), prefix) == 0
+					? result.directory.substr(prefix.length()) + "/" : "";
+				auto node = expanded.find(relative);
+
+				if(result.error != 0) {
+					if(node != expanded.end()) {
+						expanded.erase(node);
+						changed = true;
+					}
+					continue;
+				}
+
+				// changed while it was read, read it again
+				if(!cache.store(result.directory, result.elements) && node != expanded.end()) {
+					start_load(result.directory);
+					continue;
+				}
+
+				if(node != expanded.end()) {
+					node->second = result.elements;
+					changed = true;
+				}
+			}
+			return changed;
+		}
+
+		// expands or collapses a directory of the flattened listing, true if it is open now
+		bool toggle(const std::string &directory, const std::string &name) {
+			move_to(directory);
+
+			auto node = expanded.find(name);
+			if(node != expanded.end()) {
+				// everything below goes with it
+				for(auto inner = expanded.begin(); inner != expanded.end();) {
+					if(inner->first.compare(0, name.length(), name) == 0) {
+						inner = expanded.erase(inner);
+					} else {
+						inner++;
+					}
+				}
+				return false;
+			}
+
+			expanded[name] = nullptr;
+			return true;
+		}
+
+		// the listing of directory with every expanded directory in it
+		std::shared_ptr<const listing> flatten(const std::string &directory, std::shared_ptr<const listing> elements,
+				listing_cache &cache) {
+
+			move_to(directory);
+			if(expanded.empty()) {
+				return elements;
+			}
+
+			std::vector<std::shared_ptr<const listing>> current;
+			current.reserve(expanded.size());
+			for(auto &node : expanded) {
+				current.push_back(child(node.first, cache));
+			}
+
+			// nothing was replaced, the rows are the same
+			if(flattened != nullptr && elements == source && current == parts) {
+				return flattened;
+			}
+
+			std::shared_ptr<listing> result = std::make_shared<listing>();
+			result->hidden = elements->hidden;
+			result->complete = elements->complete;
+			result->responsive = elements->responsive;
+			result->mtime = elements->mtime;
+			result->ctime = elements->ctime;
+			append(*result, *elements, "");
+
+			source = elements;
+			parts = std::move(current);
+			flattened = result;
+			return flattened;
+		}
+};
+
+# endif
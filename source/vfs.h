@@ -0,0 +1,1039 @@
+# ifndef VFS_H
+# define VFS_H
+
+enum vfs_operation {
+	VFS_LIST,
+	VFS_STAT,
+	VFS_READ,
+	VFS_WRITE,
+	VFS_OPERATIONS,
+};
+
+// a directory opened through a filesystem. names come in the order the
+// filesystem keeps them and are only valid until the next call
+class vfs_directory {
+	public:
+
+		virtual ~vfs_directory() = default;
+
+		// errno of opening it, 0 if it is open
+		virtual int error() const = 0;
+
+		// next entry other than . and .., false at the end or on an error
+		virtual bool next(std::string_view &name, unsigned char &type, ino_t &inode) = 0;
+
+		// reading names is over, what it needed is given back. stat still works
+		virtual void done_reading() {}
+
+		// statx of names inside the directory, errno per name like stat_batch
+		virtual void stat(const std::vector<const char*> &names, int flags, unsigned int mask,
+				std::vector<struct statx> &results, std::vector<int> &errors) = 0;
+};
+
+// every filesystem call of the commands goes through here. the real one
+// is posix_vfs, memory_vfs makes up a filesystem for benchmarks. calls
+// return 0 or an errno, like the system calls below them
+class vfs {
+	public:
+
+		virtual ~vfs() = default;
+
+		virtual std::unique_ptr<vfs_directory> open_directory(const std::string &path) = 0;
+
+		// follow is false to look at a symlink itself
+		virtual int stat(const std::string &path, struct statx &info, bool follow = true) = 0;
+
+		// the absolute path without symlinks, . or ..
+		virtual int resolve(const std::string &path, std::string &result) = 0;
+
+		// where a symlink points, as it was written
+		virtual int read_link(const std::string &path, std::string &target) = 0;
+
+		// nullptr with errno set if it cannot be read
+		virtual std::unique_ptr<std::istream> open_file(const std::string &path) = 0;
+
+		virtual int make_directory(const std::string &path) = 0;
+
+		// fails with EEXIST if there is something already
+		virtual int create_file(const std::string &path) = 0;
+
+		virtual int rename(const std::string &from, const std::string &to) = 0;
+
+		// a file or an empty directory
+		virtual int remove(const std::string &path) = 0;
+
+		// contents and permissions of a file, to a path that does not exist yet
+		virtual int copy_file(const std::string &from, const std::string &to) = 0;
+
+		// another name for a file, to a path that does not exist yet
+		virtual int link(const std::string &from, const std::string &to) = 0;
+
+		// a symlink at path pointing to target, written as it is
+		virtual int symlink(const std::string &target, const std::string &path) = 0;
+
+		// bytes free on the filesystem of a path, -1 if unknown
+		virtual double available(const std::string &path) = 0;
+
+		bool exists(const std::string &path) {
+			struct statx info;
+			return stat(path, info) == 0;
+		}
+
+		bool is_directory(const std::string &path) {
+			struct statx info;
+			return stat(path, info) == 0 && S_ISDIR(info.stx_mode);
+		}
+
+		// removes a tree depth first. stops at the first error, failed is
+		// where it happened
+		int remove_all(const std::string &path, std::string &failed) {
+			struct statx info;
+			int error = stat(path, info, false);
+			if(error == 0 && S_ISDIR(info.stx_mode)) {
+				std::vector<std::string> names;
+				std::vector<bool> directories;
+				{
+					std::unique_ptr<vfs_directory> directory = open_directory(path);
+					error = directory->error();
+
+					std::string_view name;
+					unsigned char type;
+					ino_t inode;
+					while(error == 0 && directory->next(name, type, inode)) {
+						names.emplace_back(name);
+						directories.push_back(type == DT_DIR || type == DT_UNKNOWN);
+					}
+				}
+
+				// symlinks to directories are removed, not followed
+				for(std::size_t i = 0; error == 0 && i < names.size(); i++) {
+					std::string child = path + "/" + names[i];
+					error = directories[i] ? remove_all(child, failed) : remove(child);
+					if(error != 0 && failed.empty()) {
+						failed = child;
+					}
+				}
+			}
+
+			if(error == 0) {
+				error = remove(path);
+			}
+			if(error != 0 && failed.empty()) {
+				failed = path;
+			}
+			return error;
+		}
+
+		// copies a tree to a path that does not exist yet. symlinks are
+		// made again pointing where they did, like cp -r. stops at the
+		// first error, failed is where
+		int copy_all(const std::string &from, const std::string &to, std::string &failed) {
+			struct statx info;
+			int error = stat(from, info, false);
+			if(error != 0) {
+				failed = from;
+				return error;
+			}
+
+			if(S_ISLNK(info.stx_mode)) {
+				std::string target;
+				error = read_link(from, target);
+				if(error != 0) {
+					failed = from;
+					return error;
+				}
+				error = symlink(target, to);
+				if(error != 0) {
+					failed = to;
+				}
+				return error;
+			} else if(!S_ISDIR(info.stx_mode)) {
+				error = copy_file(from, to);
+				if(error != 0) {
+					failed = to;
+				}
+				return error;
+			}
+
+			error = make_directory(to);
+			if(error != 0) {
+				failed = to;
+				return error;
+			}
+
+			std::vector<std::string> names;
+			{
+				std::unique_ptr<vfs_directory> directory = open_directory(from);
+				if(directory->error() != 0) {
+					failed = from;
+					return directory->error();
+				}
+
+				std::string_view name;
+				unsigned char type;
+				ino_t inode;
+				while(directory->next(name, type, inode)) {
+					names.emplace_back(name);
+				}
+			}
+
+			for(const auto &name : names) {
+				error = copy_all(from + "/" + name, to + "/" + name, failed);
+				if(error != 0) {
+					return error;
+				}
+			}
+			return 0;
+		}
+
+		// the filesystem in use, the real one unless a benchmark swapped it
+		static vfs &current();
+
+		// nullptr goes back to the real one. not for while threads use it
+		static void use(vfs *filesystem);
+};
+
+class posix_directory : public vfs_directory {
+	private:
+
+		int fd = -1;
+		int open_error = 0;
+
+		// only made while names are read, the buffer is shared per thread
+		std::unique_ptr<directory_reader> reader;
+
+	public:
+
+		posix_directory(const std::string &path) {
+			stats::syscalls++;
+			fd = ::open(path.c_str(), O_RDONLY | O_DIRECTORY | O_CLOEXEC);
+			open_error = fd == -1 ? errno : 0;
+		}
+
+		~posix_directory() {
+			reader.reset();
+			if(fd != -1) {
+				close(fd);
+			}
+		}
+
+		int error() const override {
+			return open_error;
+		}
+
+		bool next(std::string_view &name, unsigned char &type, ino_t &inode) override {
+			if(fd == -1) {
+				return false;
+			}
+			if(reader == nullptr) {
+				reader = std::make_unique<directory_reader>(fd);
+			}
+			return reader->next(name, type, inode);
+		}
+
+		void done_reading() override {
+			reader.reset();
+		}
+
+		void stat(const std::vector<const char*> &names, int flags, unsigned int mask,
+				std::vector<struct statx> &results, std::vector<int> &errors) override {
+
+			if(fd == -1) {
+				results.resize(names.size());
+				errors.assign(names.size(), open_error);
+				return;
+			}
+			stat_batch::run(fd, names, flags, mask, results, errors);
+		}
+};
+
+class posix_vfs : public vfs {
+	public:
+
+		std::unique_ptr<vfs_directory> open_directory(const std::string &path) override {
+			return std::make_unique<posix_directory>(path);
+		}
+
+		int stat(const std::string &path, struct statx &info, bool follow = true) override {
+			stats::syscalls++;
+			int flags = AT_STATX_DONT_SYNC | (follow ? 0 : AT_SYMLINK_NOFOLLOW);
+			return statx(AT_FDCWD, path.c_str(), flags, STATX_BASIC_STATS, &info) == 0 ? 0 : errno;
+		}
+
+		int resolve(const std::string &path, std::string &result) override {
+			char buffer[PATH_MAX];
+			stats::syscalls++;
+			if(realpath(path.c_str(), buffer) == nullptr) {
+				return errno;
+			}
+			result = buffer;
+			return 0;
+		}
+
+		int read_link(const std::string &path, std::string &target) override {
+			char buffer[PATH_MAX];
+			stats::syscalls++;
+			ssize_t length = readlink(path.c_str(), buffer, sizeof(buffer));
+			if(length == -1) {
+				return errno;
+			}
+			target.assign(buffer, length);
+			return 0;
+		}
+
+		std::unique_ptr<std::istream> open_file(const std::string &path) override {
+			errno = 0;
+			stats::syscalls++;
+			std::unique_ptr<std::ifstream> file = std::make_unique<std::ifstream>(path);
+			if(!file->is_open()) {
+				errno = errno != 0 ? errno : ENOENT;
+				return nullptr;
+			}
+			return file;
+		}
+
+		int make_directory(const std::string &path) override {
+			stats::syscalls++;
+			return ::mkdir(path.c_str(), 0777) == 0 ? 0 : errno;
+		}
+
+		int create_file(const std::string &path) override {
+			stats::syscalls++;
+			int fd = ::open(path.c_str(), O_WRONLY | O_CREAT | O_EXCL | O_CLOEXEC, 0666);
+			if(fd == -1) {
+				return errno;
+			}
+			close(fd);
+			return 0;
+		}
+
+		int rename(const std::string &from, const std::string &to) override {
+			stats::syscalls++;
+			return ::rename(from.c_str(), to.c_str()) == 0 ? 0 : errno;
+		}
+
+		int remove(const std::string &path) override {
+			stats::syscalls++;
+			return ::remove(path.c_str()) == 0 ? 0 : errno;
+		}
+
+		// copy_file_range keeps the data in the kernel, read and write are
+		// left for filesystems it does not work across
+		int copy_file(const std::string &from, const std::string &to) override {
+			stats::syscalls++;
+			int source = ::open(from.c_str(), O_RDONLY | O_CLOEXEC);
+			if(source == -1) {
+				return errno;
+			}
+
+			struct stat info;
+			stats::syscalls++;
+			if(fstat(source, &info) != 0) {
+				int error = errno;
+				close(source);
+				return error;
+			}
+
+			stats::syscalls++;
+			int target = ::open(to.c_str(), O_WRONLY | O_CREAT | O_EXCL | O_CLOEXEC, info.st_mode & 07777);
+			if(target == -1) {
+				int error = errno;
+				close(source);
+				return error;
+			}
+
+			int error = 0;
+			bool ranged = true;
+			char buffer[65536];
+
+			while(true) {
+				ssize_t length;
+				stats::syscalls++;
+				if(ranged) {
+					length = copy_file_range(source, nullptr, target, nullptr, 1 << 30, 0);
+					if(length == -1 && (errno == EXDEV || errno == EINVAL || errno == ENOSYS || errno == EOPNOTSUPP)) {
+						ranged = false;
+						continue;
+					}
+				} else {
+					length = ::read(source, buffer, sizeof(buffer));
+					if(length > 0) {
+						stats::syscalls++;
+						if(::write(target, buffer, length) != length) {
+							error = errno != 0 ? errno : EIO;
+							break;
+						}
+					}
+				}
+
+				if(length == 0) {
+					break;
+				} else if(length == -1) {
+					if(errno == EINTR) {
+						continue;
+					}
+					error = errno;
+					break;
+				}
+				stats::bytes_read += length;
+			}
+
+			close(source);
+			if(close(target) != 0 && error == 0) {
+				error = errno;
+			}
+			return error;
+		}
+
+		int link(const std::string &from, const std::string &to) override {
+			stats::syscalls++;
+			return ::link(from.c_str(), to.c_str()) == 0 ? 0 : errno;
+		}
+
+		int symlink(const std::string &target, const std::string &path) override {
+			stats::syscalls++;
+			return ::symlink(target.c_str(), path.c_str()) == 0 ? 0 : errno;
+		}
+
+		double available(const std::string &path) override {
+			struct statvfs info;
+			stats::syscalls++;
+			if(statvfs(path.c_str(), &info) != 0) {
+				return -1;
+			}
+			return static_cast<double>(info.f_bavail) * info.f_frsize;
+		}
+};
+
+struct memory_node {
+	mode_t mode;
+	ino_t inode;
+	unsigned long size = 0;
+	long long mtime;
+
+	// the data of a file, zeros up to size if it is shorter
+	std::string content;
+
+	std::map<std::string, std::unique_ptr<memory_node>> children;
+
+	// a directory can hold files named f0 to f<generated - 1> that are
+	// made up when asked for, so huge directories cost no memory
+	std::size_t generated = 0;
+	unsigned long generated_size = 0;
+	ino_t generated_inode = 0;
+};
+
+// a made up filesystem for benchmarks. calls can be slowed down per kind
+// and made to fail below a path, so slow disks and errors halfway through
+// a copy come out the same on every run. paths are absolute, relative
+// ones count from the root. safe to use from several threads
+class memory_vfs : public vfs {
+	private:
+
+		struct injected_error {
+			std::string prefix;
+			vfs_operation operation;
+			int error;
+			unsigned long after;
+			unsigned long calls;
+		};
+
+		std::mutex mutex;
+		memory_node root;
+		ino_t next_inode = 2;
+		long long clock = 1000000000;
+
+		std::array<unsigned long, VFS_OPERATIONS> latency = {};
+		std::vector<injected_error> errors;
+
+		static std::vector<std::string> components(const std::string &path) {
+			std::vector<std::string> parts, result;
+			boost::split(parts, path, boost::is_any_of("/"));
+			for(const auto &part : parts) {
+				if(part == "" || part == ".") {
+					continue;
+				} else if(part == "..") {
+					if(!result.empty()) {
+						result.pop_back();
+					}
+				} else {
+					result.push_back(part);
+				}
+			}
+			return result;
+		}
+
+		static std::string join(const std::vector<std::string> &parts) {
+			std::string result;
+			for(const auto &part : parts) {
+				result += "/" + part;
+			}
+			return result.empty() ? "/" : result;
+		}
+
+		// index of a made up file from its name, -1 if it is none
+		static long generated_index(const memory_node &directory, const std::string &name) {
+			if(directory.generated == 0 || name.length() < 2 || name[0] != 'f'
+			|| (name[1] == '0' && name.length() != 2) || name.find_first_not_of("0123456789", 1) != std::string::npos) {
+				return -1;
+			}
+
+			errno = 0;
+			char *end;
+			unsigned long index = strtoul(name.c_str() + 1, &end, 10);
+			return errno == 0 && index < directory.generated ? static_cast<long>(index) : -1;
+		}
+
+		// writes need real nodes, made up files become ones
+		void materialize(memory_node &directory) {
+			for(std::size_t i = 0; i < directory.generated; i++) {
+				std::unique_ptr<memory_node> node = std::make_unique<memory_node>();
+				node->mode = S_IFREG | 0644;
+				node->inode = directory.generated_inode + i;
+				node->size = directory.generated_size;
+				node->mtime = directory.mtime;
+				directory.children["f" + std::to_string(i)] = std::move(node);
+			}
+			directory.generated = 0;
+		}
+
+		// nullptr with errno set if a part is missing or not a directory.
+		// a made up file is returned in scratch
+		memory_node *find(const std::vector<std::string> &parts, std::size_t count, memory_node &scratch) {
+			memory_node *node = &root;
+			for(std::size_t i = 0; i < count; i++) {
+				if(!S_ISDIR(node->mode)) {
+					errno = ENOTDIR;
+					return nullptr;
+				}
+
+				auto child = node->children.find(parts[i]);
+				if(child != node->children.end()) {
+					node = child->second.get();
+					continue;
+				}
+
+				long index = generated_index(*node, parts[i]);
+				if(index == -1) {
+					errno = ENOENT;
+					return nullptr;
+				}
+
+				scratch.mode = S_IFREG | 0644;
+				scratch.inode = node->generated_inode + index;
+				scratch.size = node->generated_size;
+				scratch.mtime = node->mtime;
+				if(i + 1 != count) {
+					errno = ENOTDIR;
+					return nullptr;
+				}
+				return &scratch;
+			}
+			return node;
+		}
+
+		// the directory a new entry goes into, nullptr with errno set
+		memory_node *parent_of(const std::vector<std::string> &parts) {
+			if(parts.empty()) {
+				errno = EEXIST;
+				return nullptr;
+			}
+
+			memory_node scratch;
+			memory_node *parent = find(parts, parts.size() - 1, scratch);
+			if(parent == &scratch) {
+				errno = ENOTDIR;
+				return nullptr;
+			}
+			if(parent != nullptr) {
+				materialize(*parent);
+			}
+			return parent;
+		}
+
+		bool taken(memory_node &directory, const std::string &name) {
+			return directory.children.count(name) != 0 || generated_index(directory, name) != -1;
+		}
+
+		std::unique_ptr<memory_node> make_node(mode_t mode) {
+			std::unique_ptr<memory_node> node = std::make_unique<memory_node>();
+			node->mode = mode;
+			node->inode = next_inode++;
+			node->mtime = ++clock;
+			return node;
+		}
+
+		static void fill(const memory_node &node, struct statx &info) {
+			memset(&info, 0, sizeof(info));
+			info.stx_mask = STATX_BASIC_STATS;
+			info.stx_mode = node.mode;
+			info.stx_ino = node.inode;
+			info.stx_size = S_ISDIR(node.mode) ? 4096 : node.size;
+			info.stx_nlink = 1;
+			info.stx_blksize = 4096;
+			info.stx_blocks = (info.stx_size + 511) / 512;
+			info.stx_mtime.tv_sec = node.mtime;
+			info.stx_ctime.tv_sec = node.mtime;
+			info.stx_dev_minor = 42;
+		}
+
+		// called before the mutex is taken, slow filesystems block only their caller
+		void wait(vfs_operation operation, std::size_t count = 1) {
+			if(latency[operation] != 0 && count != 0) {
+				std::this_thread::sleep_for(std::chrono::microseconds(latency[operation] * count));
+			}
+		}
+
+		// errno of a failure injected for the path, 0 if it goes through
+		int injected(vfs_operation operation, const std::string &path) {
+			for(auto &rule : errors) {
+				if(rule.operation == operation && path.compare(0, rule.prefix.length(), rule.prefix) == 0
+				&& rule.calls++ >= rule.after) {
+					return rule.error;
+				}
+			}
+			return 0;
+		}
+
+		class directory : public vfs_directory {
+			private:
+
+				memory_vfs *owner;
+				std::string path;
+				std::vector<std::string> parts;
+				int open_error = 0;
+
+				// where listing goes on, by name since entries can come and go
+				std::string last;
+				bool started = false;
+				std::size_t generated = 0;
+				std::string name;
+
+			public:
+
+				directory(memory_vfs *owner_, const std::string &path_) : owner(owner_), path(path_), parts(components(path_)) {
+					owner->wait(VFS_LIST);
+					std::lock_guard<std::mutex> lock(owner->mutex);
+
+					memory_node scratch;
+					memory_node *node = owner->find(parts, parts.size(), scratch);
+					open_error = node == nullptr ? errno : !S_ISDIR(node->mode) ? ENOTDIR : owner->injected(VFS_LIST, path);
+				}
+
+				int error() const override {
+					return open_error;
+				}
+
+				bool next(std::string_view &result, unsigned char &type, ino_t &inode) override {
+					if(open_error != 0) {
+						return false;
+					}
+
+					std::lock_guard<std::mutex> lock(owner->mutex);
+					memory_node scratch;
+					memory_node *node = owner->find(parts, parts.size(), scratch);
+					if(node == nullptr || !S_ISDIR(node->mode)) {
+						return false;
+					}
+
+					auto child = started ? node->children.upper_bound(last) : node->children.begin();
+					if(child != node->children.end()) {
+						started = true;
+						last = child->first;
+						name = child->first;
+						type = S_ISDIR(child->second->mode) ? DT_DIR : S_ISLNK(child->second->mode) ? DT_LNK : DT_REG;
+						inode = child->second->inode;
+					} else if(generated < node->generated) {
+						started = true;
+						name = "f" + std::to_string(generated);
+						type = DT_REG;
+						inode = node->generated_inode + generated;
+						generated++;
+					} else {
+						return false;
+					}
+
+					result = name;
+					return true;
+				}
+
+				void stat(const std::vector<const char*> &names, int flags, unsigned int mask,
+						std::vector<struct statx> &results, std::vector<int> &errors) override {
+
+					results.resize(names.size());
+					errors.assign(names.size(), 0);
+					owner->wait(VFS_STAT, names.size());
+
+					std::lock_guard<std::mutex> lock(owner->mutex);
+					std::vector<std::string> child = parts;
+					child.emplace_back();
+
+					for(std::size_t i = 0; i < names.size(); i++) {
+						child.back() = names[i];
+						memory_node scratch;
+						memory_node *node = owner->find(child, child.size(), scratch);
+						int error = node == nullptr ? errno : owner->injected(VFS_STAT, path + "/" + names[i]);
+						if(error != 0) {
+							errors[i] = error;
+						} else {
+							fill(*node, results[i]);
+						}
+					}
+				}
+		};
+
+	public:
+
+		memory_vfs() {
+			root.mode = S_IFDIR | 0755;
+			root.inode = 1;
+			root.mtime = clock;
+		}
+
+		// microseconds each call of a kind takes, per name for stat
+		void set_latency(vfs_operation operation, unsigned long microseconds) {
+			latency[operation] = microseconds;
+		}
+
+		// calls of a kind on paths starting with prefix fail with error
+		// once after calls have gone through
+		void inject_error(vfs_operation operation, const std::string &prefix, int error, unsigned long after = 0) {
+			std::lock_guard<std::mutex> lock(mutex);
+			errors.push_back({ join(components(prefix)), operation, error, after, 0 });
+		}
+
+		void clear_errors() {
+			std::lock_guard<std::mutex> lock(mutex);
+			errors.clear();
+		}
+
+		// a file of size bytes, its content is zeros unless given
+		int add_file(const std::string &path, unsigned long size, const std::string &content = "") {
+			int error = create_file(path);
+			if(error != 0) {
+				return error;
+			}
+
+			std::lock_guard<std::mutex> lock(mutex);
+			memory_node scratch;
+			std::vector<std::string> parts = components(path);
+			memory_node *node = find(parts, parts.size(), scratch);
+			node->content = content;
+			node->size = std::max<unsigned long>(size, content.length());
+			return 0;
+		}
+
+		// a directory with count made up files of size bytes each
+		int add_generated(const std::string &path, std::size_t count, unsigned long size) {
+			int error = make_directory(path);
+			if(error != 0) {
+				return error;
+			}
+
+			std::lock_guard<std::mutex> lock(mutex);
+			memory_node scratch;
+			std::vector<std::string> parts = components(path);
+			memory_node *node = find(parts, parts.size(), scratch);
+			node->generated = count;
+			node->generated_size = size;
+			node->generated_inode = next_inode;
+			next_inode += count;
+			return 0;
+		}
+
+		std::unique_ptr<vfs_directory> open_directory(const std::string &path) override {
+			return std::make_unique<directory>(this, path);
+		}
+
+		// symlinks only hold where they point and are never followed
+		int stat(const std::string &path, struct statx &info, bool follow = true) override {
+			wait(VFS_STAT);
+			std::lock_guard<std::mutex> lock(mutex);
+
+			memory_node scratch;
+			std::vector<std::string> parts = components(path);
+			memory_node *node = find(parts, parts.size(), scratch);
+			if(node == nullptr) {
+				return errno;
+			}
+
+			int error = injected(VFS_STAT, join(parts));
+			if(error == 0) {
+				fill(*node, info);
+			}
+			return error;
+		}
+
+		int resolve(const std::string &path, std::string &result) override {
+			struct statx info;
+			int error = stat(path, info);
+			if(error == 0) {
+				result = join(components(path));
+			}
+			return error;
+		}
+
+		int read_link(const std::string &path, std::string &target) override {
+			wait(VFS_STAT);
+			std::lock_guard<std::mutex> lock(mutex);
+
+			memory_node scratch;
+			std::vector<std::string> parts = components(path);
+			memory_node *node = find(parts, parts.size(), scratch);
+			if(node == nullptr) {
+				return errno;
+			} else if(!S_ISLNK(node->mode)) {
+				return EINVAL;
+			}
+
+			int error = injected(VFS_STAT, join(parts));
+			if(error == 0) {
+				target = node->content;
+			}
+			return error;
+		}
+
+		std::unique_ptr<std::istream> open_file(const std::string &path) override {
+			wait(VFS_READ);
+			std::lock_guard<std::mutex> lock(mutex);
+
+			memory_node scratch;
+			std::vector<std::string> parts = components(path);
+			memory_node *node = find(parts, parts.size(), scratch);
+			errno = node == nullptr ? errno : S_ISDIR(node->mode) ? EISDIR : injected(VFS_READ, join(parts));
+			if(errno != 0) {
+				return nullptr;
+			}
+
+			std::string content = node->content;
+			content.resize(node->size, '\0');
+			return std::make_unique<std::istringstream>(content);
+		}
+
+		int make_directory(const std::string &path) override {
+			wait(VFS_WRITE);
+			std::lock_guard<std::mutex> lock(mutex);
+
+			std::vector<std::string> parts = components(path);
+			memory_node *parent = parent_of(parts);
+			if(parent == nullptr) {
+				return errno;
+			} else if(taken(*parent, parts.back())) {
+				return EEXIST;
+			}
+
+			int error = injected(VFS_WRITE, join(parts));
+			if(error == 0) {
+				parent->children[parts.back()] = make_node(S_IFDIR | 0755);
+				parent->mtime = ++clock;
+			}
+			return error;
+		}
+
+		int create_file(const std::string &path) override {
+			wait(VFS_WRITE);
+			std::lock_guard<std::mutex> lock(mutex);
+
+			std::vector<std::string> parts = components(path);
+			memory_node *parent = parent_of(parts);
+			if(parent == nullptr) {
+				return errno;
+			} else if(taken(*parent, parts.back())) {
+				return EEXIST;
+			}
+
+			int error = injected(VFS_WRITE, join(parts));
+			if(error == 0) {
+				parent->children[parts.back()] = make_node(S_IFREG | 0644);
+				parent->mtime = ++clock;
+			}
+			return error;
+		}
+
+		int rename(const std::string &from, const std::string &to) override {
+			wait(VFS_WRITE);
+			std::lock_guard<std::mutex> lock(mutex);
+
+			std::vector<std::string> source = components(from), target = components(to);
+			if(source.empty() || target.empty()) {
+				return EBUSY;
+			} else if(target.size() > source.size() && std::equal(source.begin(), source.end(), target.begin())) {
+				return EINVAL;
+			}
+
+			memory_node *source_parent = parent_of(source);
+			if(source_parent == nullptr) {
+				return errno;
+			}
+			memory_node *target_parent = parent_of(target);
+			if(target_parent == nullptr) {
+				return errno;
+			}
+
+			auto node = source_parent->children.find(source.back());
+			if(node == source_parent->children.end()) {
+				return ENOENT;
+			}
+
+			int error = injected(VFS_WRITE, join(source));
+			if(error == 0) {
+				auto existing = target_parent->children.find(target.back());
+				if(existing != target_parent->children.end() && S_ISDIR(existing->second->mode)
+				&& !existing->second->children.empty()) {
+					return ENOTEMPTY;
+				}
+
+				std::unique_ptr<memory_node> moved = std::move(node->second);
+				source_parent->children.erase(node);
+				target_parent->children[target.back()] = std::move(moved);
+				source_parent->mtime = target_parent->mtime = ++clock;
+			}
+			return error;
+		}
+
+		int remove(const std::string &path) override {
+			wait(VFS_WRITE);
+			std::lock_guard<std::mutex> lock(mutex);
+
+			std::vector<std::string> parts = components(path);
+			memory_node *parent = parent_of(parts);
+			if(parent == nullptr) {
+				return errno;
+			}
+
+			auto node = parent->children.find(parts.back());
+			if(node == parent->children.end()) {
+				return ENOENT;
+			} else if(S_ISDIR(node->second->mode) && (!node->second->children.empty() || node->second->generated != 0)) {
+				return ENOTEMPTY;
+			}
+
+			int error = injected(VFS_WRITE, join(parts));
+			if(error == 0) {
+				parent->children.erase(node);
+				parent->mtime = ++clock;
+			}
+			return error;
+		}
+
+		int copy_file(const std::string &from, const std::string &to) override {
+			wait(VFS_READ);
+			wait(VFS_WRITE);
+			std::lock_guard<std::mutex> lock(mutex);
+
+			memory_node scratch;
+			std::vector<std::string> source = components(from), target = components(to);
+			memory_node *node = find(source, source.size(), scratch);
+			if(node == nullptr) {
+				return errno;
+			} else if(S_ISDIR(node->mode)) {
+				return EISDIR;
+			}
+
+			int error = injected(VFS_READ, join(source));
+			if(error != 0) {
+				return error;
+			}
+
+			// read before the target is made, it can be in the same directory
+			mode_t mode = node->mode;
+			unsigned long size = node->size;
+			std::string content = node->content;
+
+			memory_node *parent = parent_of(target);
+			if(parent == nullptr) {
+				return errno;
+			} else if(taken(*parent, target.back())) {
+				return EEXIST;
+			}
+
+			error = injected(VFS_WRITE, join(target));
+			if(error == 0) {
+				std::unique_ptr<memory_node> made = make_node(mode);
+				made->size = size;
+				made->content = std::move(content);
+				parent->children[target.back()] = std::move(made);
+				parent->mtime = ++clock;
+			}
+			return error;
+		}
+
+		// the new node shares the inode number and data, nothing writes to either later
+		int link(const std::string &from, const std::string &to) override {
+			wait(VFS_WRITE);
+			std::lock_guard<std::mutex> lock(mutex);
+
+			memory_node scratch;
+			std::vector<std::string> source = components(from), target = components(to);
+			memory_node *node = find(source, source.size(), scratch);
+			if(node == nullptr) {
+				return errno;
+			} else if(S_ISDIR(node->mode)) {
+				return EPERM;
+			}
+
+			memory_node copy;
+			copy.mode = node->mode;
+			copy.inode = node->inode;
+			copy.size = node->size;
+			copy.mtime = node->mtime;
+			copy.content = node->content;
+
+			memory_node *parent = parent_of(target);
+			if(parent == nullptr) {
+				return errno;
+			} else if(taken(*parent, target.back())) {
+				return EEXIST;
+			}
+
+			int error = injected(VFS_WRITE, join(target));
+			if(error == 0) {
+				parent->children[target.back()] = std::make_unique<memory_node>(std::move(copy));
+				parent->mtime = ++clock;
+			}
+			return error;
+		}
+
+		int symlink(const std::string &target, const std::string &path) override {
+			wait(VFS_WRITE);
+			std::lock_guard<std::mutex> lock(mutex);
+
+			std::vector<std::string> parts = components(path);
+			memory_node *parent = parent_of(parts);
+			if(parent == nullptr) {
+				return errno;
+			} else if(taken(*parent, parts.back())) {
+				return EEXIST;
+			}
+
+			int error = injected(VFS_WRITE, join(parts));
+			if(error == 0) {
+				std::unique_ptr<memory_node> made = make_node(S_IFLNK | 0777);
+				made->content = target;
+				made->size = target.length();
+				parent->children[parts.back()] = std::move(made);
+				parent->mtime = ++clock;
+			}
+			return error;
+		}
+
+		double available(const std::string &path) override {
+			return 1ULL << 40;
+		}
+};
+
+static vfs *&vfs_override() {
+	static vfs *instance = nullptr;
+	return instance;
+}
+
+vfs &vfs::current() {
+	static posix_vfs posix;
+	return vfs_override() != nullptr ? *vfs_override() : posix;
+}
+
+void vfs::use(vfs *filesystem) {
+	vfs_override() = filesystem;
+}
+
+# endif
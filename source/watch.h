@@ -0,0 +1,178 @@
+# ifndef WATCH_H
+# define WATCH_H
+
+// inotify watches on directories. events are only gathered here, names
+// that changed are collected per directory until the caller takes them
+class directory_watch {
+	private:
+
+		int fd = -1;
+
+		std::unordered_map<int, std::string> directories;
+		std::unordered_map<std::string, int> descriptors;
+
+		// names that changed since the last take, per directory
+		std::unordered_map<std::string, std::unordered_set<std::string>> changes;
+
+		// directories that can only be read again as a whole
+		std::unordered_set<std::string> lost;
+		bool overflow = false;
+
+		// time of the first change not taken yet
+		unsigned long first_change = 0;
+
+		void note(unsigned long now) {
+			if(first_change == 0) {
+				first_change = now;
+			}
+		}
+
+	public:
+
+		directory_watch() {
+			fd = inotify_init1(IN_NONBLOCK | IN_CLOEXEC);
+		}
+
+		~directory_watch() {
+			if(fd != -1) {
+				close(fd);
+			}
+		}
+
+		int get_fd() const {
+			return fd;
+		}
+
+		bool watching(const std::string &directory) const {
+			return descriptors.count(directory) != 0;
+		}
+
+		// false if the directory cannot be watched, it is then revalidated
+		// by its mtime instead
+		bool add(const std::string &directory) {
+			if(fd == -1) {
+				return false;
+			} else if(watching(directory)) {
+				return true;
+			}
+
+			stats::syscalls++;
+			int descriptor = inotify_add_watch(fd, directory.c_str(), IN_CREATE | IN_DELETE
+					| IN_MOVED_FROM | IN_MOVED_TO | IN_MODIFY | IN_ATTRIB | IN_CLOSE_WRITE
+					| IN_DELETE_SELF | IN_MOVE_SELF | IN_ONLYDIR | IN_EXCL_UNLINK);
+			if(descriptor == -1) {
+				return false;
+			}
+
+			// a path can reach a directory that is already watched by another name
+			auto other = directories.find(descriptor);
+			if(other != directories.end()) {
+				descriptors.erase(other->second);
+			}
+
+			directories[descriptor] = directory;
+			descriptors[directory] = descriptor;
+			return true;
+		}
+
+		void remove(const std::string &directory) {
+			auto iterator = descriptors.find(directory);
+			if(iterator == descriptors.end()) {
+				return;
+			}
+
+			stats::syscalls++;
+			inotify_rm_watch(fd, iterator->second);
+			directories.erase(iterator->second);
+			descriptors.erase(iterator);
+			changes.erase(directory);
+		}
+
+		// drains the queue, true if anything changed
+		bool read() {
+			if(fd == -1) {
+				return false;
+			}
+
+			bool changed = false;
+			alignas(struct inotify_event) char buffer[65536];
+
+			while(true) {
+				stats::syscalls++;
+				ssize_t length = ::read(fd, buffer, sizeof(buffer));
+				if(length <= 0) {
+					break;
+				}
+
+				unsigned long now = stats::now();
+
+				for(char *position = buffer; position < buffer + length;) {
+					const struct inotify_event *event = reinterpret_cast<const struct inotify_event*>(position);
+					position += sizeof(struct inotify_event) + event->len;
+
+					if(event->mask & IN_Q_OVERFLOW) {
+						overflow = true;
+						note(now);
+						changed = true;
+						continue;
+					}
+
+					auto directory = directories.find(event->wd);
+					if(directory == directories.end()) {
+						continue;
+					}
+
+					if(event->mask & (IN_DELETE_SELF | IN_MOVE_SELF | IN_IGNORED)) {
+						lost.insert(directory->second);
+						changes.erase(directory->second);
+
+						// the kernel drops the watch itself after IN_IGNORED
+						if(event->mask & IN_IGNORED) {
+							descriptors.erase(directory->second);
+							directories.erase(directory);
+						}
+					} else if(event->len != 0) {
+						changes[directory->second].insert(event->name);
+					}
+
+					note(now);
+					changed = true;
+				}
+			}
+
+			return changed;
+		}
+
+		// true once changes have waited out the coalescing window
+		bool ready() const {
+			return first_change != 0 && stats::now() - first_change >= watch_coalesce_time;
+		}
+
+		bool pending() const {
+			return first_change != 0;
+		}
+
+		// microseconds until ready, -1 without pending changes
+		long time_left() const {
+			if(first_change == 0) {
+				return -1;
+			}
+			return std::max(0L, static_cast<long>(first_change + watch_coalesce_time) - static_cast<long>(stats::now()));
+		}
+
+		// hands over what changed and starts a new window
+		void take(std::unordered_map<std::string, std::unordered_set<std::string>> &changes_,
+				std::unordered_set<std::string> &lost_, bool &overflow_) {
+
+			changes_.swap(changes);
+			lost_.swap(lost);
+			overflow_ = overflow;
+
+			changes.clear();
+			lost.clear();
+			overflow = false;
+			first_change = 0;
+		}
+};
+
+# endif